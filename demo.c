@@ -120,6 +120,16 @@ Record the maximum value that we saw in the loop above. Maybe this corresponds t
   return;
 }
 
+/*
+fake_data_generate is called by SPAWN's parallel initializer in order to compute each item of the fake readonly data string from its index.
+*/
+void
+fake_data_generate(u8 *item_base,ULONG item_idx,u8 *readonly_string_base){
+  (void)(readonly_string_base);
+  *(u16 *)(item_base)=(u16)(item_idx*item_idx*item_idx);
+  return;
+}
+
 int
 main(int argc, char *argv[]){
   u16 *fake_data_base;
@@ -173,16 +183,16 @@ Save pointers to the structures above inside the global data structure, so that
   thread_global.thread_local_list_base=thread_local_list_base;
   thread_global.simulthread_local_list_base=simulthread_local_list_base;
 /*
-Initialize the readonly data string. In reality, this might be a table of atomic weights, or a table of mathematical constants.
+Initialize the readonly data string. In reality, this might be a table of atomic weights, or a table of mathematical constants. spawn_generate() does this in parallel, on the simulthreads, so that on a NUMA machine each page lands near the CPU that first touched it rather than near the root thread. It doesn't disturb the target function or readonly string given to SPAWN_INIT().
 */
-  for(i=0;i<=(FAKE_DATA_SIZE-1);i++){
-    fake_data_base[i]=i*i*i;
-  }
+  status=spawn_generate(spawn_base,(u8 *)(fake_data_base),FAKE_DATA_SIZE-1,U16_SIZE,fake_data_generate,NULL);
 /*
-Initialize the thread local max values to 0, even though the thread initializes it anyway, just to be paranoid.
+Initialize the thread local max values to 0, even though the thread initializes it anyway, just to be paranoid. spawn_fill() with a NULL item zeroes in parallel, likewise.
 */
-  for(i=0;i<=thread_idx_max;i++){
-    thread_local_list_base[i].fake_x_max=0;
+  status|=spawn_fill(spawn_base,(u8 *)(thread_local_list_base),thread_idx_max,NULL,sizeof(thread_local_t));
+  if(status){
+    printf("Parallel initialization failed\n");
+    exit(1);
   }
 /*
 Launch (thread_idx_max+1) instances of thread_execute().
@@ -225,8 +235,10 @@ We don't really need to rewind in this example, but this is useful in cases wher
 /*
 Do it all over again, but this time, using SPAWN_ONE() instead of SPAWN().
 */
-  for(i=0;i<=thread_idx_max;i++){
-    thread_local_list_base[i].fake_x_max=0;
+  status=spawn_fill(spawn_base,(u8 *)(thread_local_list_base),thread_idx_max,NULL,sizeof(thread_local_t));
+  if(status){
+    printf("Parallel initialization failed\n");
+    exit(1);
   }
 /*
 Alias the functionality of SPAWN() using (thread_idx_max+1) invokations of SPAWN_ONE(). In reality, this would occur because don't know ahead of time how many threads we'll need, and just have to launch them opportunistically. Again, we're not allowed to call anything but SPAWN_ONE() until the next SPAWN_RETIRE_ALL(). As with SPAWN() above, beware error paths that could cause your code to forget to do this!
@@ -263,7 +275,7 @@ Display the global max, as above.
   }
   fflush(stdout);
 /*
-Mandatory memory cleanup. We don't need to SPAWN_REWIND() because we're done with *spawn_base. But if we wanted to do another SPAWN(), or another or several other instances of SPAWN_ONE(), then SPAWN_REWIND() would be required if either (1) the target function changed to something other than thread_execute or (2) the readonly string base changed to something other than &thread_global. Changing the number of simulthreads requires SPAWN_INIT() because it's assumed that this value will change rarely, as its optimum is essentially a function of the hardware and the OS, and nothing else.
+Mandatory memory cleanup. We don't need to SPAWN_REWIND() because we're done with *spawn_base. But if we wanted to do another SPAWN(), or another or several other instances of SPAWN_ONE(), then SPAWN_REWIND() would be required if either (1) the target function changed to something other than thread_execute or (2) the readonly string base changed to something other than &thread_global. Raising the number of simulthreads beyond the simulthread_idx_max given to SPAWN_INIT() requires another SPAWN_INIT(), because its optimum is essentially a function of the hardware and the OS. But SPAWN_SIMULTHREAD_LIMIT_SET() can lower it, and raise it back up to that ceiling, at any time, even from another thread while threads are in flight. That's handy when other processes on the same machine suddenly need the CPUs.
 */
   SPAWN_FREE(spawn_base);
   return 0;
@@ -23,7 +23,7 @@ License version 3 along with the Spawn Library (filename
 /*
 Build control. If possible, change the build using gcc command switches, and not by changing this file.
 */
-#define SPAWN_BUILD_ID 14
+#define SPAWN_BUILD_ID 34
 #if !(defined(_32_)||defined(_64_))
   #error "Use 'gcc -D_64_' for 64-bit or 'gcc -D_32_' for 32-bit code."
 #elif defined(_32_)&&defined(_64_)
@@ -1,4 +1,6 @@
 rm monothread_demo
 rm multithread_demo
+rm spawn_stat
 gcc -D_32_ -DPTHREAD_OFF -O3 -pthread -fno-stack-protector -omonothread_demo demo.c
 gcc -D_32_ -DPTHREAD -O3 -pthread -fno-stack-protector -omultithread_demo demo.c
+gcc -D_32_ -DPTHREAD -O3 -pthread -fno-stack-protector -ospawn_stat spawn_stat.c
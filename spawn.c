@@ -62,401 +62,6645 @@ Out:
   }
   return base;
 }
-#ifdef PTHREAD
-  void
-  spawn_multi_pthread_join(spawn_simulthread_t *simulthread_base){
+
+int
+spawn_perf_event_open(u8 kernel_exclude_status,u8 perf_idx,int group_fd){
 /*
-Force pthread_join() to succeed, or don't return. Do not call from outside Spawn.
+Open a performance counter which counts on behalf of the calling thread only, as a member of a group whose counts can all be read at once. The file descriptor is closed on exec(), so a concurrent fork() and exec() elsewhere in the process doesn't leak it. Do not call from outside Spawn.
 
 In:
 
-  simulthread_base->pthread corresponds to the simulthread to be flushed.
+  kernel_exclude_status is 1 to count only user mode events, else 0 to count kernel mode events as well. The former is required when /proc/sys/kernel/perf_event_paranoid forbids the latter.
+
+  perf_idx is one of the SPAWN_PERF_*_IDX constants.
+
+  group_fd is -1 to open a new group leader, which starts out disabled, else the file descriptor of the leader of the group to join, which counts whenever the leader does.
 
 Out:
 
-  The indicated simulthread has flushed successfully.
+  Returns -1 if the counter could not be opened, else a file descriptor. The caller must close() it.
 */
-   int pthread_status;
+  int perf_fd;
+#ifdef __linux__
+  struct perf_event_attr perf_event_attr;
 
-    do{
-      pthread_status=pthread_join(simulthread_base->pthread,NULL);
+  memset(&perf_event_attr,0,sizeof(perf_event_attr));
+  perf_event_attr.size=sizeof(perf_event_attr);
+  perf_event_attr.type=PERF_TYPE_HARDWARE;
+  switch(perf_idx){
+  case SPAWN_PERF_BRANCH_MISS_IDX:
+    perf_event_attr.config=PERF_COUNT_HW_BRANCH_MISSES;
+    break;
+  case SPAWN_PERF_CONTEXT_SWITCH_IDX:
+    perf_event_attr.type=PERF_TYPE_SOFTWARE;
+    perf_event_attr.config=PERF_COUNT_SW_CONTEXT_SWITCHES;
+    break;
+  case SPAWN_PERF_CYCLE_IDX:
+    perf_event_attr.config=PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case SPAWN_PERF_INSTRUCTION_IDX:
+    perf_event_attr.config=PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  default:
 /*
-No matter what, do not exit this loop until the pthread_join has succeeded. If we hang, we hang. Better that, than corrupting memory and risking uncontrolled OS calls due to freeing memory in use by another thread.
+The kernel documents PERF_COUNT_HW_CACHE_MISSES as "usually" counting last level cache misses. That's the most portable LLC event available.
 */
-    }while(pthread_status);
-    return;
+    perf_event_attr.config=PERF_COUNT_HW_CACHE_MISSES;
   }
+  perf_event_attr.disabled=(group_fd<0);
+  perf_event_attr.exclude_hv=1;
+  perf_event_attr.exclude_kernel=kernel_exclude_status;
+  perf_event_attr.read_format=PERF_FORMAT_GROUP;
+  perf_fd=(int)(syscall(SYS_perf_event_open,&perf_event_attr,0,-1,group_fd,PERF_FLAG_FD_CLOEXEC));
+#else
+  perf_fd=-1;
+#endif
+  return perf_fd;
+}
 
-  u8
-  spawn_multi_one(spawn_t *spawn_base,ULONG unique_idx){
+void
+spawn_perf_begin(spawn_perf_state_t *perf_state_base,spawn_simulthread_t *simulthread_base){
 /*
-Spawn a thread asynchronously.
+Zero the performance counters of a simulthread, first opening them as one group if this is its first thread since its counters were last closed. Do not call from outside Spawn.
 
 In:
 
-  unique_idx is a thread index used once until spawn_multi_retire_all() is called, after which it may be reused. It's used to address the reason for which this function is called instead of spawn_multi(), namely, that the thread indexes of interest aren't known ahead of time. For example, a master thread could browse a list, looking for work to do. Then some of the items in the list would invoke slave threads, whereas others would not. In this example, a linearly increasing thread index would be of little use to the target function. unique_idx gets around this problem by permitting thread indexes to be sparse, and even out-of-order.
+  *perf_state_base is as allocated by spawn_perf_enable().
 
-  *spawn_base is as returned by spawn_multi_init().
+  *simulthread_base is the simulthread about to call its target function, on the OS thread which will call it.
 
 Out:
 
-  Returns 1 on failure, else 0. Success means that the thread was launched (but might not have retired). Failure will only be returned in the case of a fatal error, as opposed to a temporary failure caused by the OS being overloaded with threads.
-
-  Regardless of the return value, the caller must not call any other Spawn function, except this one, until spawn_multi_retire_all() has been called -- unless the call involves purely orthogonal writable data structures, including a separate *spawn_base.
+  simulthread_base->perf_fd_list contains a file descriptor for each counter, or -1 if it's unavailable, and simulthread_base->perf_group_fd is that of the group leader, or -1 if none could be opened. The caller must call spawn_perf_end().
 */
-    void (*function_base)(spawn_simulthread_context_t *);
-    int pthread_status;
-    u8 simulthread_active_status;
-    spawn_simulthread_t *simulthread_base;
-    u32 simulthread_idx_max;
-    u32 simulthread_launch_idx;
-    u8 simulthread_launched_status;
-    spawn_simulthread_t *simulthread_list_base;
-    u32 simulthread_retire_idx;
-    u8 status;
+  u8 available_mask;
+  int group_fd;
+  u8 kernel_exclude_mask;
+  int perf_fd;
+  u8 perf_idx;
 
-    function_base=spawn_base->function_base;
-    simulthread_list_base=spawn_base->simulthread_list_base;
-    simulthread_idx_max=spawn_base->simulthread_idx_max;
-    simulthread_launch_idx=spawn_base->simulthread_launch_idx;
-    simulthread_retire_idx=spawn_base->simulthread_retire_idx;
-    simulthread_active_status=spawn_base->simulthread_active_status;
-    if(simulthread_active_status&&(simulthread_launch_idx==simulthread_retire_idx)){
-/*
-We're maxed out on simulthreads. Retire one so we can launch one.
-*/
-      simulthread_base=&simulthread_list_base[simulthread_retire_idx];
-      spawn_multi_pthread_join(simulthread_base);
-      simulthread_retire_idx++;
-      if(simulthread_retire_idx>simulthread_idx_max){
-        simulthread_retire_idx=0;
+  group_fd=simulthread_base->perf_group_fd;
+  if(group_fd<0){
+    available_mask=perf_state_base->available_mask;
+    kernel_exclude_mask=perf_state_base->kernel_exclude_mask;
+    for(perf_idx=0;perf_idx<=SPAWN_PERF_IDX_MAX;perf_idx++){
+      perf_fd=-1;
+      if((available_mask>>perf_idx)&1){
+        perf_fd=spawn_perf_event_open((kernel_exclude_mask>>perf_idx)&1,perf_idx,group_fd);
+        if((perf_fd>=0)&&(group_fd<0)){
+          group_fd=perf_fd;
+        }
       }
-/*
-We were maxed out on simulthreads, then retired one of them. The only way that there could be no more active simulthreads is if simulthread_idx_max==0.
-*/
-      simulthread_active_status=(!!simulthread_idx_max);
+      simulthread_base->perf_fd_list[perf_idx]=perf_fd;
     }
+    simulthread_base->perf_group_fd=group_fd;
+#ifdef __linux__
+    if(group_fd>=0){
+      ioctl(group_fd,PERF_EVENT_IOC_ENABLE,PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+#ifdef __linux__
+  if(group_fd>=0){
+    ioctl(group_fd,PERF_EVENT_IOC_RESET,PERF_IOC_FLAG_GROUP);
+  }
+#endif
+  return;
+}
+
+void
+spawn_perf_close(spawn_simulthread_t *simulthread_base){
 /*
-Launch the new simulthread with thread_idx==unique_idx.
-*/
-    simulthread_base=&simulthread_list_base[simulthread_launch_idx];
-    simulthread_base->context.thread_idx=unique_idx;
-    do{
-      pthread_status=pthread_create(&simulthread_base->pthread,NULL,(void *)(function_base),&simulthread_base->context);
-      if(pthread_status){
-        status=1;
-        simulthread_launched_status=0;
-        if((pthread_status==EAGAIN)||((pthread_status==ENOMEM)&&simulthread_active_status)){
-/*
-We may or may not have active simulthreads, but the OS is too busy to launch another thread. (If we have ENOMEM but no active simulthreads, that's a fatal error because there's no indication that the OS will ever be able to launch another thread. In that case, we can't arrive here.) If any simulthreads are active, then retire one of them, so we can hopefully launch another one.
+Close the performance counters of a simulthread, if open. Do not call from outside Spawn.
+
+In:
+
+  *simulthread_base is the simulthread whose counters to close. In multithreaded mode, it must be called on the OS thread which opened them, which is about to exit, because they only count that thread.
+
+Out:
+
+  simulthread_base->perf_group_fd is -1, and so is every entry of simulthread_base->perf_fd_list which was valid.
 */
-          status=0;
-          if(simulthread_active_status){
-            spawn_multi_pthread_join(simulthread_base);
-            simulthread_retire_idx++;
-            if(simulthread_retire_idx>simulthread_idx_max){
-              simulthread_retire_idx=0;
-            }
-            simulthread_active_status=(simulthread_launch_idx!=simulthread_retire_idx);
-          }
-        }
-      }else{
-        status=0;
-        simulthread_launched_status=1;
-        simulthread_active_status=simulthread_launched_status;
-        simulthread_launch_idx++;
-        if(simulthread_launch_idx>simulthread_idx_max){
-          simulthread_launch_idx=0;
-        }
+  u8 perf_idx;
+
+  if(simulthread_base->perf_group_fd>=0){
+    for(perf_idx=0;perf_idx<=SPAWN_PERF_IDX_MAX;perf_idx++){
+      if(simulthread_base->perf_fd_list[perf_idx]>=0){
+        close(simulthread_base->perf_fd_list[perf_idx]);
+        simulthread_base->perf_fd_list[perf_idx]=-1;
       }
-    }while(!(status|simulthread_launched_status));
-    spawn_base->simulthread_launch_idx=simulthread_launch_idx;
-    spawn_base->simulthread_retire_idx=simulthread_retire_idx;
-    spawn_base->simulthread_active_status=simulthread_active_status;
-    return status;
+    }
+    simulthread_base->perf_group_fd=-1;
   }
+  return;
+}
 
-  u8
-  spawn_multi(spawn_t *spawn_base,ULONG thread_idx_max){
+void
+spawn_perf_end(spawn_perf_state_t *perf_state_base,spawn_simulthread_t *simulthread_base,ULONG thread_idx){
 /*
-Keep the OS thread engine as busy as possible with pending threads, within the specified simultaneous thread limit. Make sure your threads are long enough that the typical launch latency (perhpas 1 ms) isn't significant.
+Read the performance counters zeroed by spawn_perf_begin() with a single system call, and accumulate their counts. The counters stay open for the next thread on the same OS thread. Do not call from outside Spawn.
 
 In:
 
-  This function must not be recursed or nested within spawn_multi_one(). Otherwise it's possible that OS thread handles will be exhausted.
+  *perf_state_base is as allocated by spawn_perf_enable().
 
-  thread_idx_max is the maximum thread number.
+  *simulthread_base is as passed to spawn_perf_begin().
 
-  *spawn_base is as returned by spawn_multi_init().
+  thread_idx is the thread_idx of the calling thread.
 
 Out:
 
-  Returns 1 if not all threads were launched successfully, else 0. Failure will only be returned in the case of a fatal error, as opposed to a temporary failure caused by the OS being overloaded with threads.
-
-  Regardless of the return value, the caller must not call any other Spawn function, including this one, until spawn_multi_retire_all() has been called -- unless the call involves purely orthogonal writable data structures, including a separate *spawn_base.
+  The counts have been added to the per-simulthread totals (which need no locking because only one thread at a time occupies a given simulthread) and, atomically, to the per-range totals.
 */
-    ULONG i;
-    u8 status;
+  u64 count;
+  u64 count_list[SPAWN_PERF_IDX_MAX+2];
+  u64 count_idx;
+  u8 perf_idx;
+  spawn_perf_t *range_perf_base;
+  ULONG range_idx;
+  spawn_perf_t *simulthread_perf_base;
 
-    i=0;
-    do{
-      status=spawn_multi_one(spawn_base,i);
-    }while((!status)&&((i++)!=thread_idx_max));
-    return status;
+  range_idx=thread_idx>>perf_state_base->range_size_log2;
+  range_idx=MIN(range_idx,perf_state_base->range_idx_max);
+  range_perf_base=&perf_state_base->range_perf_list_base[range_idx];
+  simulthread_perf_base=&perf_state_base->simulthread_perf_list_base[simulthread_base->context.simulthread_idx];
+/*
+A group read returns the number of counters, followed by their counts in the order in which they joined the group, which is ascending perf_idx.
+*/
+  count_list[0]=0;
+  if(simulthread_base->perf_group_fd>=0){
+    if(read(simulthread_base->perf_group_fd,count_list,sizeof(count_list))<(ssize_t)(sizeof(u64))){
+      count_list[0]=0;
+    }
+  }
+  count_idx=1;
+  for(perf_idx=0;perf_idx<=SPAWN_PERF_IDX_MAX;perf_idx++){
+    if(simulthread_base->perf_fd_list[perf_idx]>=0){
+      count=0;
+      if(count_idx<=MIN(count_list[0],SPAWN_PERF_IDX_MAX+1)){
+        count=count_list[count_idx];
+      }
+      count_idx++;
+      simulthread_perf_base->count_list[perf_idx]+=count;
+      __atomic_fetch_add(&range_perf_base->count_list[perf_idx],count,__ATOMIC_RELAXED);
+    }
   }
+  simulthread_perf_base->task_count++;
+  __atomic_fetch_add(&range_perf_base->task_count,1,__ATOMIC_RELAXED);
+  return;
+}
 
-  void
-  spawn_multi_retire_all(spawn_t *spawn_base){
+void
+spawn_perf_free(spawn_t *spawn_base){
 /*
-Retire all pending threads.
+Close any performance counters left open, and free performance counter storage, if any. Do not call from outside Spawn.
 
 In:
 
-  *spawn_base is as returned by spawn_multi_init().
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
 
 Out:
 
-  All pending threads, if any, have finished. The caller must, in general, call spawn_multi_rewind(), but can sometimes avoid that step (see its documentation). If all work is done, then the caller can directly call spawn_multi_free() without calling spawn_multi_rewind().
+  spawn_base->perf_state_base is NULL.
 */
-    u8 simulthread_active_status;
-    spawn_simulthread_t *simulthread_base;
-    u32 simulthread_idx_max;  
-    u32 simulthread_launch_idx;
-    spawn_simulthread_t *simulthread_list_base;
-    u32 simulthread_retire_idx;
-
-    simulthread_active_status=spawn_base->simulthread_active_status;
-    if(simulthread_active_status){
-      simulthread_list_base=spawn_base->simulthread_list_base;
-      simulthread_idx_max=spawn_base->simulthread_idx_max;
-      simulthread_launch_idx=spawn_base->simulthread_launch_idx;
-      simulthread_retire_idx=spawn_base->simulthread_retire_idx;
-      do{
-        simulthread_base=&simulthread_list_base[simulthread_retire_idx];
-        spawn_multi_pthread_join(simulthread_base);
-        simulthread_retire_idx++;
-        if(simulthread_retire_idx>simulthread_idx_max){
-          simulthread_retire_idx=0;
-        }
-      }while(simulthread_retire_idx!=simulthread_launch_idx);
-    }
-    spawn_base->simulthread_launch_idx=0;
-    spawn_base->simulthread_retire_idx=0;
-    spawn_base->simulthread_active_status=0;
-    return;
-  }
+  spawn_perf_state_t *perf_state_base;
+  u32 simulthread_idx;
 
-  void
-  spawn_multi_free(spawn_t *spawn_base){
-    if(spawn_base){
-      spawn_free(spawn_base->simulthread_list_base);
-      spawn_free(spawn_base);
-    }
-    return;
+  simulthread_idx=0;
+  do{
+    spawn_perf_close(&spawn_base->simulthread_list_base[simulthread_idx]);
+  }while((simulthread_idx++)!=spawn_base->simulthread_idx_max);
+  perf_state_base=spawn_base->perf_state_base;
+  if(perf_state_base){
+    spawn_free(perf_state_base->range_perf_list_base);
+    spawn_free(perf_state_base->simulthread_perf_list_base);
+    spawn_free(perf_state_base);
+    spawn_base->perf_state_base=NULL;
   }
+  return;
+}
 
-  void
-  spawn_multi_rewind(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base,spawn_t *spawn_base){
+void
+spawn_perf_reset(spawn_t *spawn_base){
 /*
-Reset the Spawn engine without changing the memory map. It is not necessary to call this function unless a new function_base or readonly_string_base is to be used in a subsequent spawn_multi() or spawn_multi_one(), in which case, it must be called after spawn_multi_retire_all().
+Zero all performance counter totals. Must not be called while any threads are in flight.
 
 In:
 
-  function_base is as defined in spawn_multi_init():In.
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(), and has been passed to spawn_perf_enable().
 
-  readonly_string_base is as defined in spawn_multi_init():In.
+Out:
 
-  *spawn_base is as returned by spawn_multi_init().
+  All per-range and per-simulthread totals are 0.
 */
-    u32 i;
-    u32 simulthread_idx_max;
-    spawn_simulthread_t *simulthread_list_base;
+  spawn_perf_state_t *perf_state_base;
 
-    spawn_base->function_base=function_base;
-    spawn_base->simulthread_launch_idx=0;
-    spawn_base->simulthread_retire_idx=0;
-    spawn_base->simulthread_active_status=0;
-    simulthread_list_base=spawn_base->simulthread_list_base;
-    simulthread_idx_max=spawn_base->simulthread_idx_max;
-    i=0;
-    do{
-      simulthread_list_base[i].context.readonly_string_base=readonly_string_base;
-    }while((i++)!=simulthread_idx_max);
-    return;
+  perf_state_base=spawn_base->perf_state_base;
+  if(perf_state_base){
+    memset(perf_state_base->range_perf_list_base,0,(size_t)(perf_state_base->range_idx_max+1)*sizeof(spawn_perf_t));
+    memset(perf_state_base->simulthread_perf_list_base,0,((size_t)(spawn_base->simulthread_idx_max)+1)*sizeof(spawn_perf_t));
   }
+  return;
+}
 
-  spawn_t *
-  spawn_multi_init(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base,u32 simulthread_idx_max){
+u8
+spawn_perf_enable(spawn_t *spawn_base,ULONG thread_idx_max,u8 range_size_log2){
 /*
-Initialize the Spawn engine for multithreaded mode.
+Collect hardware performance counters around every invocation of function_base. Each simulthread opens its counters as one group when it starts running threads, and closes them when its OS thread exits, so bulk submissions and monothreaded mode open them only once. Otherwise, it costs 2 syscalls per thread to reset and read them, so it's intended for tuning, not for production runs which are already tuned. In monothreaded mode, the counters count the thread which first ran a thread after this call, so call it again if a different thread will call spawn_mono() and friends. Must not be called while any threads are in flight.
 
 In:
 
-  function_base is the base of a function which accepts a (spawn_simulthread_context_t *) and has no return value (because all communication occurs via memory). Typically, this is a bridge function which then invokes the "real" thread code.
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
 
-  readonly_string_base is NULL, or the base of a string to which all threads shall be given read access, via spawn_simulthread_context_t.readonly_string_base.
+  thread_idx_max is the maximum thread_idx expected, which determines how many thread index ranges to allocate. Threads with greater thread_idx are tallied into the last range.
 
-  simulthread_idx_max is 1 less than the maximum allowable number of simultaneous threads ("simulthreads") in flight. All values are valid. Useful to limit resource consumption and kernel overhead due to excessive simulthreads. The simulthread index gets copied to the spawn_simulthread_context_t.simulthread_idx, which will never exceed spawn_simulthread_context_t.thread_idx. (In monothreaded mode, simulthread_idx is always 0.) Both values can be read via the pointer passed to the function at function_base.
+  range_size_log2 is the log2 of the number of consecutive thread indexes which are aggregated into each range. For example, 0 gives one range per thread_idx, whereas (ULONG_BITS-1) gives a single range.
 
 Out:
 
-  Returns NULL on failure, else a (spawn_t *) for use with future calls to the Spawn engine.
+  Returns 1 on failure due to insufficient memory, else 0. Success is returned even if the OS offers no counters at all, in which case the counts are reported as unavailable. Any previous totals are discarded.
 */
-    u32 i;
-    spawn_simulthread_t *simulthread_list_base;
-    u64 simulthread_list_size;
-    spawn_t *spawn_base;
+  u8 available_mask;
+  u8 kernel_exclude_mask;
+  u8 kernel_exclude_status;
+  int perf_fd;
+  u8 perf_idx;
+  spawn_perf_state_t *perf_state_base;
+  ULONG range_idx_max;
+  u64 range_perf_list_size;
+  u64 simulthread_perf_list_size;
+  u8 status;
 
-    simulthread_list_size=simulthread_idx_max;
-    simulthread_list_size++;
-    simulthread_list_size*=sizeof(spawn_simulthread_t);
-    simulthread_list_base=NULL;
-    if(simulthread_list_size<=ULONG_MAX){
-      simulthread_list_base=(spawn_simulthread_t *)(spawn_malloc((ULONG)(simulthread_list_size-1)));
+  spawn_perf_free(spawn_base);
+  range_size_log2=MIN(range_size_log2,ULONG_BIT_MAX);
+  range_idx_max=thread_idx_max>>range_size_log2;
+  range_perf_list_size=range_idx_max;
+  range_perf_list_size++;
+  range_perf_list_size*=sizeof(spawn_perf_t);
+  simulthread_perf_list_size=spawn_base->simulthread_idx_max;
+  simulthread_perf_list_size++;
+  simulthread_perf_list_size*=sizeof(spawn_perf_t);
+  status=1;
+  perf_state_base=(spawn_perf_state_t *)(spawn_malloc(sizeof(spawn_perf_state_t)-1));
+  if(perf_state_base){
+    perf_state_base->range_perf_list_base=NULL;
+    perf_state_base->simulthread_perf_list_base=NULL;
+    perf_state_base->range_idx_max=range_idx_max;
+    perf_state_base->range_size_log2=range_size_log2;
+    spawn_base->perf_state_base=perf_state_base;
+    if((range_perf_list_size<=ULONG_MAX)&&(simulthread_perf_list_size<=ULONG_MAX)){
+      perf_state_base->range_perf_list_base=(spawn_perf_t *)(spawn_malloc((ULONG)(range_perf_list_size-1)));
+      perf_state_base->simulthread_perf_list_base=(spawn_perf_t *)(spawn_malloc((ULONG)(simulthread_perf_list_size-1)));
     }
-    spawn_base=NULL;
-    if(simulthread_list_base){
-      spawn_base=(spawn_t *)(spawn_malloc(sizeof(spawn_t)-1));
-      if(spawn_base){
-        spawn_base->function_base=function_base;
-        spawn_base->simulthread_list_base=simulthread_list_base;
-        spawn_base->simulthread_idx_max=simulthread_idx_max;
-        spawn_base->simulthread_launch_idx=0;
-        spawn_base->simulthread_retire_idx=0;
-        spawn_base->simulthread_active_status=0;
-        i=0;
+    if(perf_state_base->range_perf_list_base&&perf_state_base->simulthread_perf_list_base){
+      status=0;
+/*
+Probe each counter once now, so that threads don't waste syscalls on counters which the OS won't provide. Prefer to count kernel mode events too, because context switches occur there, but settle for user mode if that's all the OS allows.
+*/
+      available_mask=0;
+      kernel_exclude_mask=0;
+      for(perf_idx=0;perf_idx<=SPAWN_PERF_IDX_MAX;perf_idx++){
+        kernel_exclude_status=0;
         do{
-          simulthread_list_base[i].context.readonly_string_base=readonly_string_base;
-          simulthread_list_base[i].context.simulthread_idx=i;
-        }while((i++)!=simulthread_idx_max);
-      }else{
-        spawn_free(simulthread_list_base);
+          perf_fd=spawn_perf_event_open(kernel_exclude_status,perf_idx,-1);
+        }while((perf_fd<0)&&((kernel_exclude_status++)==0));
+        if(perf_fd>=0){
+          available_mask|=(u8)(1U<<perf_idx);
+          kernel_exclude_mask|=(u8)(kernel_exclude_status<<perf_idx);
+          close(perf_fd);
+        }
       }
+      perf_state_base->available_mask=available_mask;
+      perf_state_base->kernel_exclude_mask=kernel_exclude_mask;
+      spawn_perf_reset(spawn_base);
+    }else{
+      spawn_perf_free(spawn_base);
     }
-    return spawn_base;
   }
-#else
-  u8
-  spawn_mono_one(spawn_t *spawn_base,ULONG unique_idx){
+  return status;
+}
+
+spawn_perf_t *
+spawn_perf_range_get(spawn_t *spawn_base,ULONG range_idx){
 /*
-Monothreaded emulation of spawn_multi_one() for verification purposes or unicore environments.
+Get the performance counter totals for a range of thread indexes. Must not be called while any threads are in flight.
 
 In:
 
-  unique_idx is as defined in spawn_multi_one():In.
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(), and has been passed to spawn_perf_enable().
 
-  *spawn_base is as returned by spawn_mono_init().
+  range_idx is (thread_idx>>range_size_log2), where range_size_log2 is as given to spawn_perf_enable(). Out-of-range values are clipped to the last range.
 
 Out:
 
-  Returns 0 for compatibility with spawn_multi_one().
-
-  The caller must not call any other Spawn function except this one, until spawn_mono_rewind() or spawn_mono_free() has been called.
+  Returns NULL if counters are not enabled, else the base of the totals for the range. spawn_perf_t.count_list[SPAWN_PERF_*_IDX] is meaningless unless spawn_perf_available_mask_get() has bit SPAWN_PERF_*_IDX set.
 */
-    void (*function_base)(spawn_simulthread_context_t *);
-    spawn_simulthread_context_t *simulthread_context_base;
-    spawn_simulthread_t *simulthread_list_base;
+  spawn_perf_state_t *perf_state_base;
+  spawn_perf_t *range_perf_base;
 
-    function_base=spawn_base->function_base;
-    simulthread_list_base=spawn_base->simulthread_list_base;
-    simulthread_context_base=&simulthread_list_base->context;
-    simulthread_context_base->thread_idx=unique_idx;
-    function_base(simulthread_context_base);
-    return 0;
+  perf_state_base=spawn_base->perf_state_base;
+  range_perf_base=NULL;
+  if(perf_state_base){
+    range_idx=MIN(range_idx,perf_state_base->range_idx_max);
+    range_perf_base=&perf_state_base->range_perf_list_base[range_idx];
   }
+  return range_perf_base;
+}
 
-  u8
-  spawn_mono(spawn_t *spawn_base,ULONG thread_idx_max){
+spawn_perf_t *
+spawn_perf_simulthread_get(spawn_t *spawn_base,u32 simulthread_idx){
 /*
-Monothreaded emulation of spawn_multi() for verification purposes or unicore environments.
+Get the performance counter totals for a simulthread. Must not be called while any threads are in flight.
 
 In:
 
-  thread_idx_max is as defined in spawn_multi():In.
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(), and has been passed to spawn_perf_enable().
 
-  *spawn_base is as returned by spawn_mono_init().
+  simulthread_idx is at most simulthread_idx_max as given to spawn_multi_init(), or 0 in monothreaded mode.
 
 Out:
 
-  Returns 0 for compatibility with spawn_multi().
+  Returns NULL if counters are not enabled or simulthread_idx is out of range, else the base of the totals for the simulthread.
 */
-    void (*function_base)(spawn_simulthread_context_t *);
-    ULONG i;
-    spawn_simulthread_context_t *simulthread_context_base;
-    spawn_simulthread_t *simulthread_list_base;
+  spawn_perf_state_t *perf_state_base;
+  spawn_perf_t *simulthread_perf_base;
 
-    simulthread_list_base=spawn_base->simulthread_list_base;
-    function_base=spawn_base->function_base;
-    simulthread_context_base=&simulthread_list_base->context;
-    i=0;
-    do{
-      simulthread_context_base->thread_idx=i;
-      function_base((void *)(simulthread_context_base));
-    }while((i++)!=thread_idx_max);
-    return 0;
+  perf_state_base=spawn_base->perf_state_base;
+  simulthread_perf_base=NULL;
+  if(perf_state_base&&(simulthread_idx<=spawn_base->simulthread_idx_max)){
+    simulthread_perf_base=&perf_state_base->simulthread_perf_list_base[simulthread_idx];
   }
+  return simulthread_perf_base;
+}
 
-  void
-  spawn_mono_free(spawn_t *spawn_base){
-    if(spawn_base){
-      spawn_free(spawn_base->simulthread_list_base);
-      spawn_free(spawn_base);
+u8
+spawn_perf_available_mask_get(spawn_t *spawn_base){
+/*
+Find out which performance counters the OS was willing to provide.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+Out:
+
+  Returns a mask in which bit SPAWN_PERF_*_IDX is set if and only if the corresponding counter is being collected. Returns 0 if spawn_perf_enable() hasn't been called.
+*/
+  u8 available_mask;
+
+  available_mask=0;
+  if(spawn_base->perf_state_base){
+    available_mask=spawn_base->perf_state_base->available_mask;
+  }
+  return available_mask;
+}
+
+void
+spawn_perf_line_print(FILE *file_base,char *label_base,u64 label_idx,u8 available_mask,spawn_perf_t *perf_base){
+/*
+Print one line of the spawn_perf_print() report. Do not call from outside Spawn.
+*/
+  u64 count;
+  u8 perf_idx;
+
+  fprintf(file_base,"%-11s %10llu %10llu",label_base,(unsigned long long)(label_idx),(unsigned long long)(perf_base->task_count));
+  for(perf_idx=0;perf_idx<=SPAWN_PERF_IDX_MAX;perf_idx++){
+    count=perf_base->count_list[perf_idx];
+    if((available_mask>>perf_idx)&1){
+      fprintf(file_base," %16llu",(unsigned long long)(count));
+    }else{
+      fprintf(file_base," %16s","n/a");
     }
-    return;
   }
+/*
+Instructions per cycle and LLC misses per thousand instructions, both in thousandths, are the figures that usually decide whether a thread is compute-bound or memory-bound.
+*/
+  if(((available_mask>>SPAWN_PERF_CYCLE_IDX)&(available_mask>>SPAWN_PERF_INSTRUCTION_IDX)&1)&&perf_base->count_list[SPAWN_PERF_CYCLE_IDX]){
+    count=perf_base->count_list[SPAWN_PERF_INSTRUCTION_IDX]*1000/perf_base->count_list[SPAWN_PERF_CYCLE_IDX];
+    fprintf(file_base," %4llu.%03llu",(unsigned long long)(count/1000),(unsigned long long)(count%1000));
+  }else{
+    fprintf(file_base," %8s","n/a");
+  }
+  if(((available_mask>>SPAWN_PERF_INSTRUCTION_IDX)&(available_mask>>SPAWN_PERF_LLC_MISS_IDX)&1)&&perf_base->count_list[SPAWN_PERF_INSTRUCTION_IDX]){
+    count=perf_base->count_list[SPAWN_PERF_LLC_MISS_IDX]*1000000/perf_base->count_list[SPAWN_PERF_INSTRUCTION_IDX];
+    fprintf(file_base," %4llu.%03llu",(unsigned long long)(count/1000),(unsigned long long)(count%1000));
+  }else{
+    fprintf(file_base," %8s","n/a");
+  }
+  fprintf(file_base,"\n");
+  return;
+}
 
-  void
-  spawn_mono_rewind(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base,spawn_t *spawn_base){
+void
+spawn_perf_print(spawn_t *spawn_base,FILE *file_base){
 /*
-Reset the Spawn engine without changing the memory map. It is not necessary to call this function unless a new function_base or readonly_string_base is to be used in a subsequent spawn_mono() or spawn_mono_one().
+Print a text report of the performance counter totals: the grand total, then one line per simulthread, then one line per thread index range. Must not be called while any threads are in flight.
 
 In:
 
-  function_base is as defined in spawn_mono_init():In.
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
 
-  readonly_string_base is as defined in spawn_mono_init():In.
+  *file_base is the stream to which to print, for example stdout.
 
-  *spawn_base is as returned by spawn_mono_init().
+Out:
+
+  The report has been printed, or a note that counters aren't enabled.
 */
-    spawn_simulthread_t *simulthread_list_base;
+  u8 available_mask;
+  u8 perf_idx;
+  spawn_perf_state_t *perf_state_base;
+  ULONG range_idx;
+  u32 simulthread_idx;
+  spawn_perf_t *simulthread_perf_base;
+  spawn_perf_t total_perf;
 
-    spawn_base->function_base=function_base;
-    simulthread_list_base=spawn_base->simulthread_list_base;
-    simulthread_list_base->context.readonly_string_base=readonly_string_base;
+  perf_state_base=spawn_base->perf_state_base;
+  if(!perf_state_base){
+    fprintf(file_base,"Spawn performance counters are not enabled.\n");
     return;
   }
+  available_mask=perf_state_base->available_mask;
+  memset(&total_perf,0,sizeof(total_perf));
+  simulthread_idx=0;
+  do{
+    simulthread_perf_base=&perf_state_base->simulthread_perf_list_base[simulthread_idx];
+    for(perf_idx=0;perf_idx<=SPAWN_PERF_IDX_MAX;perf_idx++){
+      total_perf.count_list[perf_idx]+=simulthread_perf_base->count_list[perf_idx];
+    }
+    total_perf.task_count+=simulthread_perf_base->task_count;
+  }while((simulthread_idx++)!=spawn_base->simulthread_idx_max);
+  fprintf(file_base,"%-11s %10s %10s %16s %16s %16s %16s %16s %8s %8s\n","scope","index","threads","branch_misses","context_switches","cycles","instructions","llc_misses","ipc","llc_mpki");
+  spawn_perf_line_print(file_base,"total",0,available_mask,&total_perf);
+  simulthread_idx=0;
+  do{
+    spawn_perf_line_print(file_base,"simulthread",simulthread_idx,available_mask,&perf_state_base->simulthread_perf_list_base[simulthread_idx]);
+  }while((simulthread_idx++)!=spawn_base->simulthread_idx_max);
+  range_idx=0;
+  do{
+    spawn_perf_line_print(file_base,"range",(u64)(range_idx)<<perf_state_base->range_size_log2,available_mask,&perf_state_base->range_perf_list_base[range_idx]);
+  }while((range_idx++)!=perf_state_base->range_idx_max);
+  return;
+}
 
-  spawn_t *
-  spawn_mono_init(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base){
+u64
+spawn_nanosecond_get(void){
 /*
-Initialize the Spawn engine for monothreaded mode.
+Read the monotonic clock. Do not call from outside Spawn.
+
+Out:
+
+  Returns the number of nanoseconds since some arbitrary point in the past, which is fixed for the life of the process.
+*/
+  u64 nanoseconds;
+  struct timespec timespec;
+
+  clock_gettime(CLOCK_MONOTONIC,&timespec);
+  nanoseconds=(u64)(timespec.tv_sec)*1000000000ULL;
+  nanoseconds+=(u64)(timespec.tv_nsec);
+  return nanoseconds;
+}
+
+void
+spawn_speculate_free(spawn_t *spawn_base){
+/*
+Disable speculative reexecution and free its storage, if any. Must not be called while any threads are in flight.
 
 In:
 
-  function_base is as defined in spawn_multi_init():In.
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
 
-  readonly_string_base is as defined in spawn_multi_init():In
+Out:
+
+  spawn_base->speculate_state_base is NULL.
+*/
+  spawn_speculate_state_t *speculate_state_base;
+
+  speculate_state_base=spawn_base->speculate_state_base;
+  if(speculate_state_base){
+#ifdef PTHREAD
+    pthread_cond_destroy(&speculate_state_base->cond);
+    pthread_mutex_destroy(&speculate_state_base->mutex);
+#endif
+    spawn_free(speculate_state_base->attempt_list_base);
+    spawn_free(speculate_state_base->state_list_base);
+    spawn_free(speculate_state_base);
+    spawn_base->speculate_state_base=NULL;
+  }
+  return;
+}
+
+u8
+spawn_speculate_enable(spawn_t *spawn_base,u8 *result_list_base,ULONG result_size,ULONG thread_idx_max,u64 straggler_nanoseconds){
+/*
+Enable speculative reexecution of straggler threads. Once spawn_multi_retire_all() is called, such that no more threads will be launched, it will use each simulthread which becomes idle to launch a duplicate of the longest-running thread which has not yet finished, provided that it has been running for at least straggler_nanoseconds. Whichever attempt finishes first has its result committed; the other attempt's result is discarded. Each thread_idx is duplicated at most once. In monothreaded mode, there are no duplicates, but results are committed the same way, so the same target function works in both modes. Must not be called while any threads are in flight.
+
+The target function must be idempotent: it must not write anything other than its simulthread-local scratch space and the buffer returned by spawn_speculate_attempt_base_get(), because it might execute twice concurrently with the same thread_idx. It may call spawn_speculate_lost_get() occasionally, and return early if that returns 1, because its result would be discarded anyway. Note that spawn_multi_retire_all() still waits for the losing attempt to return.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+  result_list_base is the base of ((thread_idx_max+1)*result_size) bytes to which the winning attempt for each thread_idx is committed, at offset (thread_idx*result_size).
+
+  result_size is the nonzero size of each thread's result.
+
+  thread_idx_max is the maximum thread_idx that will be launched, including the unique_idx passed to spawn_multi_one(). Threads launched beyond it still run, but are never duplicated, and their results are discarded.
+
+  straggler_nanoseconds is the minimum time that a thread must have been running before it's considered a straggler worth duplicating. 0 means that any thread still running after all threads have been launched is worth duplicating, which is appropriate if idle simulthreads are otherwise worthless.
 
 Out:
 
-  Returns NULL on failure, else a (spawn_t *) for use with future calls to the Spawn engine.
+  Returns 1 on failure due to insufficient memory, result_size==0, or an open streaming sink or memoization, else 0. Any previous speculation settings are discarded.
 */
-    spawn_simulthread_t *simulthread_list_base;
-    spawn_t *spawn_base;
+  u64 attempt_list_size;
+#ifdef PTHREAD
+  pthread_condattr_t condattr;
+#endif
+  u32 simulthread_idx;
+  spawn_speculate_state_t *speculate_state_base;
+  u8 status;
 
-    simulthread_list_base=(spawn_simulthread_t *)(spawn_malloc(sizeof(spawn_simulthread_t)-1));
-    spawn_base=NULL;
-    if(simulthread_list_base){
-      spawn_base=(spawn_t *)(spawn_malloc(sizeof(spawn_t)-1));
-      if(spawn_base){
-        spawn_base->function_base=function_base;
-        spawn_base->simulthread_list_base=simulthread_list_base;
-        simulthread_list_base->context.readonly_string_base=readonly_string_base;
-        simulthread_list_base->context.simulthread_idx=0;
+  spawn_speculate_free(spawn_base);
+  attempt_list_size=spawn_base->simulthread_idx_max;
+  attempt_list_size++;
+  attempt_list_size*=result_size;
+  status=1;
+  if(result_size&&(!spawn_base->memo_state_base)&&(!spawn_base->sink_state_base)&&(attempt_list_size<=ULONG_MAX)&&(thread_idx_max!=ULONG_MAX)){
+    speculate_state_base=(spawn_speculate_state_t *)(spawn_malloc(sizeof(spawn_speculate_state_t)-1));
+    if(speculate_state_base){
+      speculate_state_base->attempt_list_base=spawn_malloc((ULONG)(attempt_list_size-1));
+      speculate_state_base->state_list_base=spawn_malloc(thread_idx_max);
+      if(speculate_state_base->attempt_list_base&&speculate_state_base->state_list_base){
+        status=0;
+#ifdef PTHREAD
+        status=!!pthread_mutex_init(&speculate_state_base->mutex,NULL);
+        if(!status){
+          pthread_condattr_init(&condattr);
+          pthread_condattr_setclock(&condattr,CLOCK_MONOTONIC);
+          status=!!pthread_cond_init(&speculate_state_base->cond,&condattr);
+          pthread_condattr_destroy(&condattr);
+          if(status){
+            pthread_mutex_destroy(&speculate_state_base->mutex);
+          }
+        }
+#endif
+      }
+      if(!status){
+        memset(speculate_state_base->state_list_base,0,(size_t)(thread_idx_max)+1);
+        speculate_state_base->simulthread_active_count=0;
+        simulthread_idx=0;
+        do{
+          spawn_base->simulthread_list_base[simulthread_idx].active_status=0;
+        }while((simulthread_idx++)!=spawn_base->simulthread_idx_max);
+        speculate_state_base->result_list_base=result_list_base;
+        speculate_state_base->straggler_nanoseconds=straggler_nanoseconds;
+        speculate_state_base->result_size=result_size;
+        speculate_state_base->thread_idx_max=thread_idx_max;
+        spawn_base->speculate_state_base=speculate_state_base;
       }else{
-        spawn_free(simulthread_list_base);
+        spawn_free(speculate_state_base->attempt_list_base);
+        spawn_free(speculate_state_base->state_list_base);
+        spawn_free(speculate_state_base);
       }
     }
-    return spawn_base;
   }
+  return status;
+}
+
+u8 *
+spawn_speculate_attempt_base_get(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Find where the target function should write its result when speculative reexecution is enabled.
+
+In:
+
+  *simulthread_context_base is as passed to the target function.
+
+Out:
+
+  Returns the base of result_size bytes, as given to spawn_speculate_enable(), private to this attempt. After the target function returns, it's committed to the result list if this is the first attempt at this thread_idx to finish.
+*/
+  spawn_speculate_state_t *speculate_state_base;
+  spawn_t *spawn_base;
+
+  spawn_base=(spawn_t *)(((spawn_simulthread_t *)(simulthread_context_base))->spawn_base);
+  speculate_state_base=spawn_base->speculate_state_base;
+  return &speculate_state_base->attempt_list_base[simulthread_context_base->simulthread_idx*speculate_state_base->result_size];
+}
+
+u8
+spawn_speculate_lost_get(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Find out whether another attempt at the same thread_idx has already been committed. This is cheap enough to call in an inner loop.
+
+In:
+
+  *simulthread_context_base is as passed to the target function.
+
+Out:
+
+  Returns 1 if the result of this attempt will be discarded, so the target function may as well return now, else 0.
+*/
+  spawn_speculate_state_t *speculate_state_base;
+  spawn_t *spawn_base;
+  u8 state;
+
+  spawn_base=(spawn_t *)(((spawn_simulthread_t *)(simulthread_context_base))->spawn_base);
+  speculate_state_base=spawn_base->speculate_state_base;
+  state=SPAWN_SPECULATE_COMMITTED;
+  if(simulthread_context_base->thread_idx<=speculate_state_base->thread_idx_max){
+    state=__atomic_load_n(&speculate_state_base->state_list_base[simulthread_context_base->thread_idx],__ATOMIC_RELAXED);
+  }
+  return (u8)(state&SPAWN_SPECULATE_COMMITTED);
+}
+
+void
+spawn_speculate_commit(spawn_speculate_state_t *speculate_state_base,spawn_simulthread_t *simulthread_base){
+/*
+Commit the result of an attempt if it's the first to finish for its thread_idx, and that thread_idx is within the range given to spawn_speculate_enable(), then tell spawn_multi_retire_all() that its simulthread is idle. Do not call from outside Spawn.
+
+In:
+
+  *speculate_state_base is as allocated by spawn_speculate_enable().
+
+  *simulthread_base is the simulthread whose target function just returned.
+
+Out:
+
+  The attempt has been committed or discarded.
+*/
+  ULONG result_size;
+  u8 state;
+  ULONG thread_idx;
+
+  result_size=speculate_state_base->result_size;
+  thread_idx=simulthread_base->context.thread_idx;
+  state=SPAWN_SPECULATE_COMMITTED;
+  if(thread_idx<=speculate_state_base->thread_idx_max){
+#ifdef PTHREAD
+    state=__atomic_fetch_or(&speculate_state_base->state_list_base[thread_idx],SPAWN_SPECULATE_COMMITTED,__ATOMIC_ACQ_REL);
+#else
+/*
+In monothreaded mode, there are no duplicates, and no spawn_multi_retire_all() to clear the commit states between batches, so every attempt wins.
+*/
+    state=0;
+#endif
+  }
+  if(!(state&SPAWN_SPECULATE_COMMITTED)){
+    memcpy(&speculate_state_base->result_list_base[thread_idx*result_size],&speculate_state_base->attempt_list_base[simulthread_base->context.simulthread_idx*result_size],(size_t)(result_size));
+  }
+#ifdef PTHREAD
+  pthread_mutex_lock(&speculate_state_base->mutex);
+  simulthread_base->done_status=1;
+  pthread_cond_signal(&speculate_state_base->cond);
+  pthread_mutex_unlock(&speculate_state_base->mutex);
+#endif
+  return;
+}
+
+ULONG
+spawn_sink_ready_count_get(spawn_sink_state_t *sink_state_base){
+/*
+Count the consecutive finished threads, starting from the next one to be written, whose output can be written in a single batch. Do not call from outside Spawn.
+
+In:
+
+  *sink_state_base is as allocated by spawn_sink_open(), with its mutex held by the caller in multithreaded mode.
+
+Out:
+
+  Returns the number of buffers ready to be written, which is at most (iovec_idx_max+1).
+*/
+  spawn_sink_buffer_t *buffer_list_base;
+  ULONG buffer_idx;
+  ULONG ready_count;
+  ULONG ready_count_max;
+  ULONG window_idx_max;
+  ULONG write_idx;
+
+  buffer_list_base=sink_state_base->buffer_list_base;
+  window_idx_max=sink_state_base->window_idx_max;
+  write_idx=sink_state_base->write_idx;
+  ready_count=0;
+  if(write_idx<=sink_state_base->thread_idx_max){
+    ready_count_max=sink_state_base->thread_idx_max-write_idx;
+    ready_count_max=MIN(ready_count_max,sink_state_base->iovec_idx_max)+1;
+    buffer_idx=write_idx%(window_idx_max+1);
+    while((ready_count!=ready_count_max)&&buffer_list_base[buffer_idx].done_status){
+      ready_count++;
+      buffer_idx=(buffer_idx!=window_idx_max)?(buffer_idx+1):0;
+    }
+  }
+  return ready_count;
+}
+
+void
+spawn_sink_writev(spawn_sink_state_t *sink_state_base,ULONG ready_count){
+/*
+Write a batch of finished buffers to the file descriptor with as few writev() calls as possible, then make their window slots available to subsequent threads. Do not call from outside Spawn.
+
+In:
+
+  *sink_state_base is as allocated by spawn_sink_open(). In multithreaded mode, its mutex must not be held by the caller, which must be its writer thread.
+
+  ready_count is the return value of spawn_sink_ready_count_get().
+
+Out:
+
+  The buffers have been written, unless a write error occurred now or previously, in which case sink_state_base->error_status is 1 and the buffers have been discarded. Either way, their sizes are 0 but their allocations are retained for reuse. write_idx has not been updated.
+*/
+  spawn_sink_buffer_t *buffer_base;
+  spawn_sink_buffer_t *buffer_list_base;
+  ULONG buffer_idx;
+  ULONG i;
+  ULONG iovec_count;
+  struct iovec *iovec_list_base;
+  ssize_t write_size;
+
+  buffer_list_base=sink_state_base->buffer_list_base;
+  iovec_list_base=sink_state_base->iovec_list_base;
+  buffer_idx=sink_state_base->write_idx%(sink_state_base->window_idx_max+1);
+  iovec_count=0;
+  for(i=0;i<ready_count;i++){
+    buffer_base=&buffer_list_base[buffer_idx];
+    if(buffer_base->size){
+      iovec_list_base[iovec_count].iov_base=buffer_base->base;
+      iovec_list_base[iovec_count].iov_len=(size_t)(buffer_base->size);
+      iovec_count++;
+    }
+    buffer_base->size=0;
+    buffer_idx=(buffer_idx!=sink_state_base->window_idx_max)?(buffer_idx+1):0;
+  }
+/*
+error_status is also set by simulthreads which fail in spawn_sink_begin() or spawn_sink_emit(), concurrently with this writer, so it's accessed atomically.
+*/
+  while(iovec_count&&!__atomic_load_n(&sink_state_base->error_status,__ATOMIC_RELAXED)){
+    write_size=writev(sink_state_base->fd,iovec_list_base,(int)(iovec_count));
+    if(write_size<0){
+      if(errno!=EINTR){
+        __atomic_store_n(&sink_state_base->error_status,1,__ATOMIC_RELAXED);
+      }
+      continue;
+    }
+/*
+Skip over whatever was written, which might not be everything.
+*/
+    while(iovec_count&&((size_t)(write_size)>=iovec_list_base->iov_len)){
+      write_size-=(ssize_t)(iovec_list_base->iov_len);
+      iovec_list_base++;
+      iovec_count--;
+    }
+    if(iovec_count){
+      iovec_list_base->iov_base=(u8 *)(iovec_list_base->iov_base)+write_size;
+      iovec_list_base->iov_len-=(size_t)(write_size);
+    }
+  }
+  return;
+}
+
+void
+spawn_sink_retire(spawn_sink_state_t *sink_state_base,ULONG ready_count){
+/*
+Advance the reorder window past buffers which spawn_sink_writev() has written. Do not call from outside Spawn.
+
+In:
+
+  *sink_state_base is as allocated by spawn_sink_open(), with its mutex held by the caller in multithreaded mode.
+
+  ready_count is as given to spawn_sink_writev().
+
+Out:
+
+  The buffers are available to subsequent threads.
+*/
+  ULONG buffer_idx;
+  ULONG i;
+
+  buffer_idx=sink_state_base->write_idx%(sink_state_base->window_idx_max+1);
+  for(i=0;i<ready_count;i++){
+    sink_state_base->buffer_list_base[buffer_idx].done_status=0;
+    buffer_idx=(buffer_idx!=sink_state_base->window_idx_max)?(buffer_idx+1):0;
+  }
+  sink_state_base->write_idx+=ready_count;
+  return;
+}
+
+#ifdef PTHREAD
+  void *
+  spawn_sink_writer(void *sink_state_base_void){
+/*
+Write finished buffers in thread_idx order as they become available, until spawn_sink_close() is called and nothing more is ready. This is the start routine of the writer pthread. Do not call from outside Spawn.
+
+In:
+
+  sink_state_base_void is a (spawn_sink_state_t *) as allocated by spawn_sink_open().
+
+Out:
+
+  Returns NULL, for compatibility with pthread_create().
+*/
+    ULONG ready_count;
+    spawn_sink_state_t *sink_state_base;
+
+    sink_state_base=(spawn_sink_state_t *)(sink_state_base_void);
+    pthread_mutex_lock(&sink_state_base->mutex);
+    do{
+      ready_count=spawn_sink_ready_count_get(sink_state_base);
+      if(ready_count){
+        pthread_mutex_unlock(&sink_state_base->mutex);
+        spawn_sink_writev(sink_state_base,ready_count);
+        pthread_mutex_lock(&sink_state_base->mutex);
+        spawn_sink_retire(sink_state_base,ready_count);
+        pthread_cond_broadcast(&sink_state_base->producer_cond);
+      }else if(sink_state_base->close_status){
+        break;
+      }else{
+        pthread_cond_wait(&sink_state_base->writer_cond,&sink_state_base->mutex);
+      }
+    }while(1);
+    pthread_mutex_unlock(&sink_state_base->mutex);
+    return NULL;
+  }
+#endif
+
+void
+spawn_sink_begin(spawn_sink_state_t *sink_state_base,spawn_simulthread_t *simulthread_base){
+/*
+Wait until the thread_idx of a simulthread fits in the reorder window, so that its output has somewhere to go. Do not call from outside Spawn.
+
+In:
+
+  *sink_state_base is as allocated by spawn_sink_open().
+
+  *simulthread_base is the simulthread about to call its target function.
+
+Out:
+
+  simulthread_base->sink_status is 1 if the target function may call spawn_sink_emit(), else 0 because its thread_idx is out of range or already written, in which case sink_state_base->error_status is 1.
+*/
+  ULONG thread_idx;
+
+  thread_idx=simulthread_base->context.thread_idx;
+  simulthread_base->sink_status=0;
+#ifdef PTHREAD
+  pthread_mutex_lock(&sink_state_base->mutex);
+/*
+Don't wait for an out-of-range thread_idx, because write_idx stops at (thread_idx_max+1), so the window would never reach it.
+*/
+  while((sink_state_base->write_idx<=thread_idx)&&(thread_idx<=sink_state_base->thread_idx_max)&&((thread_idx-sink_state_base->write_idx)>sink_state_base->window_idx_max)){
+    pthread_cond_wait(&sink_state_base->producer_cond,&sink_state_base->mutex);
+  }
+#endif
+/*
+In monothreaded mode, there's no other thread to advance the window, so a thread_idx too far ahead of its predecessors is an error, just like one which is out of range or already written.
+*/
+  if((sink_state_base->write_idx<=thread_idx)&&(thread_idx<=sink_state_base->thread_idx_max)&&((thread_idx-sink_state_base->write_idx)<=sink_state_base->window_idx_max)){
+    simulthread_base->sink_status=1;
+  }else{
+    __atomic_store_n(&sink_state_base->error_status,1,__ATOMIC_RELAXED);
+  }
+#ifdef PTHREAD
+  pthread_mutex_unlock(&sink_state_base->mutex);
+#endif
+  return;
+}
+
+void
+spawn_sink_end(spawn_sink_state_t *sink_state_base,spawn_simulthread_t *simulthread_base){
+/*
+Mark the output of a simulthread as complete, and write out whatever is now ready. Do not call from outside Spawn.
+
+In:
+
+  *sink_state_base is as allocated by spawn_sink_open().
+
+  *simulthread_base is the simulthread whose target function just returned.
+
+Out:
+
+  The writer has been notified, or in monothreaded mode, has run.
+*/
+  spawn_sink_buffer_t *buffer_base;
+#ifndef PTHREAD
+  ULONG ready_count;
 #endif
+  ULONG thread_idx;
+
+  if(simulthread_base->sink_status){
+    thread_idx=simulthread_base->context.thread_idx;
+    buffer_base=&sink_state_base->buffer_list_base[thread_idx%(sink_state_base->window_idx_max+1)];
+#ifdef PTHREAD
+    pthread_mutex_lock(&sink_state_base->mutex);
+    buffer_base->done_status=1;
+    if(thread_idx==sink_state_base->write_idx){
+      pthread_cond_signal(&sink_state_base->writer_cond);
+    }
+    pthread_mutex_unlock(&sink_state_base->mutex);
+#else
+    buffer_base->done_status=1;
+    while((ready_count=spawn_sink_ready_count_get(sink_state_base))){
+      spawn_sink_writev(sink_state_base,ready_count);
+      spawn_sink_retire(sink_state_base,ready_count);
+    }
+#endif
+  }
+  return;
+}
+
+u8
+spawn_sink_emit(spawn_simulthread_context_t *simulthread_context_base,u8 *record_base,ULONG record_size){
+/*
+Append a record to the output of the calling thread. The records of each thread are written contiguously, in the order emitted, and the outputs of all threads are written in ascending thread_idx order, as soon as all lesser thread indexes have finished.
+
+In:
+
+  *simulthread_context_base is as passed to the target function.
+
+  *record_base is the record to emit.
+
+  record_size is the size of the record. May be 0.
+
+Out:
+
+  Returns 1 if the record could not be stored due to insufficient memory, or because the thread_idx was rejected by the sink, else 0. Either way, spawn_sink_close() will return failure.
+*/
+  spawn_sink_buffer_t *buffer_base;
+  u8 *base;
+  ULONG size;
+  ULONG size_max;
+  spawn_simulthread_t *simulthread_base;
+  spawn_sink_state_t *sink_state_base;
+  u8 status;
+
+  simulthread_base=(spawn_simulthread_t *)(simulthread_context_base);
+  sink_state_base=((spawn_t *)(simulthread_base->spawn_base))->sink_state_base;
+  status=1;
+  if(simulthread_base->sink_status){
+    buffer_base=&sink_state_base->buffer_list_base[simulthread_context_base->thread_idx%(sink_state_base->window_idx_max+1)];
+    size=buffer_base->size+record_size;
+    status=(size<record_size);
+    if((!status)&&(buffer_base->size_max<size)){
+/*
+Grow the buffer geometrically, so that many small records don't cost many reallocations. The allocation is retained for reuse by subsequent threads in the same window slot.
+*/
+      size_max=buffer_base->size_max<<1;
+      size_max=MAX(size_max,size);
+      base=(u8 *)(spawn_malloc(size_max-1));
+      status=!base;
+      if(!status){
+        memcpy(base,buffer_base->base,(size_t)(buffer_base->size));
+        spawn_free(buffer_base->base);
+        buffer_base->base=base;
+        buffer_base->size_max=size_max;
+      }
+    }
+    if(!status){
+      memcpy(&buffer_base->base[buffer_base->size],record_base,(size_t)(record_size));
+      buffer_base->size=size;
+    }else{
+      __atomic_store_n(&sink_state_base->error_status,1,__ATOMIC_RELAXED);
+    }
+  }
+  return status;
+}
+
+u8
+spawn_sink_close(spawn_t *spawn_base){
+/*
+Write out all remaining output, and close the streaming sink. Must be called after spawn_multi_retire_all() in multithreaded mode. The file descriptor is not closed.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+Out:
+
+  Returns 1 if the sink was not open, or any write or allocation failed, or any thread_idx was rejected, or not every thread_idx from 0 through thread_idx_max has finished, else 0.
+*/
+  ULONG buffer_idx;
+  spawn_sink_state_t *sink_state_base;
+  u8 status;
+
+  sink_state_base=spawn_base->sink_state_base;
+  status=1;
+  if(sink_state_base){
+#ifdef PTHREAD
+    pthread_mutex_lock(&sink_state_base->mutex);
+    sink_state_base->close_status=1;
+    pthread_cond_signal(&sink_state_base->writer_cond);
+    pthread_mutex_unlock(&sink_state_base->mutex);
+    while(pthread_join(sink_state_base->writer_pthread,NULL));
+    pthread_cond_destroy(&sink_state_base->producer_cond);
+    pthread_cond_destroy(&sink_state_base->writer_cond);
+    pthread_mutex_destroy(&sink_state_base->mutex);
+#endif
+    status=__atomic_load_n(&sink_state_base->error_status,__ATOMIC_RELAXED)|(sink_state_base->write_idx!=(sink_state_base->thread_idx_max+1));
+    buffer_idx=0;
+    do{
+      spawn_free(sink_state_base->buffer_list_base[buffer_idx].base);
+    }while((buffer_idx++)!=sink_state_base->window_idx_max);
+    spawn_free(sink_state_base->buffer_list_base);
+    spawn_free(sink_state_base->iovec_list_base);
+    spawn_free(sink_state_base);
+    spawn_base->sink_state_base=NULL;
+  }
+  return status;
+}
+
+u8
+spawn_sink_open(spawn_t *spawn_base,int fd,ULONG thread_idx_max,ULONG window_idx_max){
+/*
+Open a streaming sink, through which threads emit variable-size output records with spawn_sink_emit(). A bounded reorder window releases the output of each thread in ascending thread_idx order as soon as all lesser thread indexes have finished, and it's written to a file descriptor with batched writev() calls. In multithreaded mode, the writing is done by a dedicated pthread, which is not counted as a simulthread. Must not be called while any threads are in flight.
+
+Every thread_idx from 0 through thread_idx_max must be launched exactly once, in approximately ascending order, as spawn_multi() does. A thread whose thread_idx is more than (window_idx_max+1) ahead of the least unfinished thread_idx waits before calling its target function, which bounds memory usage to the (window_idx_max+1) largest outputs. Speculative reexecution must not be enabled, because duplicate attempts would emit duplicate records.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+  fd is a file descriptor open for writing.
+
+  thread_idx_max is as given to spawn_multi() or spawn_mono().
+
+  window_idx_max is 1 less than the number of threads whose output can be held at once. It should be at least simulthread_idx_max, as given to spawn_multi_init(), or some simulthreads will be idle waiting for the window to advance. It's clipped to thread_idx_max.
+
+Out:
+
+  Returns 1 on failure due to insufficient memory, or because a sink is already open or speculative reexecution or memoization is enabled, else 0. spawn_sink_close() must eventually be called, after spawn_multi_retire_all().
+*/
+  u64 buffer_list_size;
+  ULONG iovec_idx_max;
+  spawn_sink_state_t *sink_state_base;
+  u8 status;
+
+  status=1;
+  window_idx_max=MIN(window_idx_max,thread_idx_max);
+  iovec_idx_max=MIN(window_idx_max,(ULONG)(IOV_MAX-1));
+  buffer_list_size=window_idx_max;
+  buffer_list_size++;
+  buffer_list_size*=sizeof(spawn_sink_buffer_t);
+  if((!spawn_base->memo_state_base)&&(!spawn_base->sink_state_base)&&(!spawn_base->speculate_state_base)&&(buffer_list_size<=ULONG_MAX)&&(thread_idx_max!=ULONG_MAX)){
+    sink_state_base=(spawn_sink_state_t *)(spawn_malloc(sizeof(spawn_sink_state_t)-1));
+    if(sink_state_base){
+      sink_state_base->buffer_list_base=(spawn_sink_buffer_t *)(spawn_malloc((ULONG)(buffer_list_size-1)));
+      sink_state_base->iovec_list_base=(struct iovec *)(spawn_malloc((ULONG)(((iovec_idx_max+1)*sizeof(struct iovec))-1)));
+      if(sink_state_base->buffer_list_base&&sink_state_base->iovec_list_base){
+        memset(sink_state_base->buffer_list_base,0,(size_t)(buffer_list_size));
+        sink_state_base->iovec_idx_max=iovec_idx_max;
+        sink_state_base->thread_idx_max=thread_idx_max;
+        sink_state_base->window_idx_max=window_idx_max;
+        sink_state_base->write_idx=0;
+        sink_state_base->fd=fd;
+        sink_state_base->close_status=0;
+        sink_state_base->error_status=0;
+        status=0;
+#ifdef PTHREAD
+        status=1;
+        if(!pthread_mutex_init(&sink_state_base->mutex,NULL)){
+          if(!pthread_cond_init(&sink_state_base->producer_cond,NULL)){
+            if(!pthread_cond_init(&sink_state_base->writer_cond,NULL)){
+              status=!!pthread_create(&sink_state_base->writer_pthread,NULL,spawn_sink_writer,sink_state_base);
+              if(status){
+                pthread_cond_destroy(&sink_state_base->writer_cond);
+              }
+            }
+            if(status){
+              pthread_cond_destroy(&sink_state_base->producer_cond);
+            }
+          }
+          if(status){
+            pthread_mutex_destroy(&sink_state_base->mutex);
+          }
+        }
+#endif
+      }
+      if(!status){
+        spawn_base->sink_state_base=sink_state_base;
+      }else{
+        spawn_free(sink_state_base->buffer_list_base);
+        spawn_free(sink_state_base->iovec_list_base);
+        spawn_free(sink_state_base);
+      }
+    }
+  }
+  return status;
+}
+
+void
+spawn_log_ring_copy(u8 *ring_base,ULONG ring_size,u64 ring_idx,u8 *base,ULONG size,u8 read_status){
+/*
+Copy bytes into or out of a log ring, wrapping around its end if necessary. Do not call from outside Spawn.
+
+In:
+
+  ring_base is the base of the ring.
+
+  ring_size is the size of the ring, which is a power of 2.
+
+  ring_idx is the position in the ring at which to start, before wrapping.
+
+  base is the base of the bytes outside the ring.
+
+  size is the number of bytes to copy, at most ring_size.
+
+  read_status is 1 to copy from the ring to base, else 0 to copy from base to the ring.
+
+Out:
+
+  The bytes have been copied.
+*/
+  ULONG offset;
+  ULONG size_before_wrap;
+
+  offset=(ULONG)(ring_idx)&(ring_size-1);
+  size_before_wrap=MIN(size,ring_size-offset);
+  if(read_status){
+    memcpy(base,&ring_base[offset],(size_t)(size_before_wrap));
+    memcpy(&base[size_before_wrap],ring_base,(size_t)(size-size_before_wrap));
+  }else{
+    memcpy(&ring_base[offset],base,(size_t)(size_before_wrap));
+    memcpy(ring_base,&base[size_before_wrap],(size_t)(size-size_before_wrap));
+  }
+  return;
+}
+
+void
+spawn_log_stage_flush(spawn_log_state_t *log_state_base){
+/*
+Write the staged records of a log to its file descriptor. Do not call from outside Spawn.
+
+In:
+
+  *log_state_base is as allocated by spawn_log_open().
+
+Out:
+
+  The stage is empty. Its contents have been written, unless a write error occurred now or previously, in which case log_state_base->error_status is 1 and they've been discarded.
+*/
+  u8 *stage_base;
+  ULONG stage_idx;
+  ssize_t write_size;
+
+  stage_base=log_state_base->stage_base;
+  stage_idx=log_state_base->stage_idx;
+  while(stage_idx&&!log_state_base->error_status){
+    write_size=write(log_state_base->fd,stage_base,(size_t)(stage_idx));
+    if(write_size<0){
+      if(errno!=EINTR){
+        log_state_base->error_status=1;
+      }
+      continue;
+    }
+    stage_base+=write_size;
+    stage_idx-=(ULONG)(write_size);
+  }
+  log_state_base->stage_idx=0;
+  return;
+}
+
+void
+spawn_log_drain(spawn_log_state_t *log_state_base){
+/*
+Move every complete record from the rings of a log to its stage, formatting them as text if so requested, and write them out in as few system calls as the stage size allows. Must only be called by one thread at a time, which is the drainer in multithreaded mode. Do not call from outside Spawn.
+
+In:
+
+  *log_state_base is as allocated by spawn_log_open().
+
+Out:
+
+  Every record which was complete on entry has been written, or discarded due to a write error, and its space in its ring has been released.
+*/
+  u64 head;
+  spawn_log_record_t record;
+  spawn_log_ring_t *ring_base;
+  u32 ring_idx;
+  ULONG ring_size;
+  ULONG stage_idx;
+  u64 tail;
+  int text_size;
+
+  ring_size=log_state_base->ring_size;
+  ring_idx=0;
+  do{
+    ring_base=&log_state_base->ring_list_base[ring_idx];
+    head=ring_base->head;
+    tail=__atomic_load_n(&ring_base->tail,__ATOMIC_ACQUIRE);
+    while(head!=tail){
+      spawn_log_ring_copy(ring_base->base,ring_size,head,(u8 *)(&record),sizeof(spawn_log_record_t),1);
+/*
+A record and its text prefix always fit in an empty stage, which is at least (ring_size+SPAWN_LOG_TEXT_SIZE_MAX+1) bytes.
+*/
+      if((log_state_base->stage_size-log_state_base->stage_idx)<(sizeof(spawn_log_record_t)+SPAWN_LOG_TEXT_SIZE_MAX+1+record.size)){
+        spawn_log_stage_flush(log_state_base);
+      }
+      stage_idx=log_state_base->stage_idx;
+      if(log_state_base->text_status){
+        text_size=snprintf((char *)(&log_state_base->stage_base[stage_idx]),SPAWN_LOG_TEXT_SIZE_MAX,"%llu %llu %u ",(unsigned long long)(record.nanoseconds),(unsigned long long)(record.thread_idx),record.simulthread_idx);
+        stage_idx+=(ULONG)(MAX(text_size,0));
+      }else{
+        memcpy(&log_state_base->stage_base[stage_idx],&record,sizeof(spawn_log_record_t));
+        stage_idx+=sizeof(spawn_log_record_t);
+      }
+      spawn_log_ring_copy(ring_base->base,ring_size,head+sizeof(spawn_log_record_t),&log_state_base->stage_base[stage_idx],record.size,1);
+      stage_idx+=record.size;
+      if(log_state_base->text_status){
+        log_state_base->stage_base[stage_idx]='\n';
+        stage_idx++;
+      }
+      log_state_base->stage_idx=stage_idx;
+      head+=sizeof(spawn_log_record_t)+record.size;
+    }
+    __atomic_store_n(&ring_base->head,head,__ATOMIC_RELEASE);
+  }while((ring_idx++)!=log_state_base->ring_idx_max);
+  spawn_log_stage_flush(log_state_base);
+  return;
+}
+
+#ifdef PTHREAD
+  void *
+  spawn_log_drainer(void *log_state_base_void){
+/*
+Drain the rings of a log every SPAWN_LOG_DRAIN_NANOSECONDS until spawn_log_close() is called, then drain them one last time. This is the start routine of the drainer pthread. Do not call from outside Spawn.
+
+In:
+
+  log_state_base_void is a (spawn_log_state_t *) as allocated by spawn_log_open().
+
+Out:
+
+  Returns NULL, for compatibility with pthread_create().
+*/
+    u8 close_status;
+    spawn_log_state_t *log_state_base;
+    struct timespec timespec;
+
+    log_state_base=(spawn_log_state_t *)(log_state_base_void);
+    timespec.tv_sec=0;
+    timespec.tv_nsec=SPAWN_LOG_DRAIN_NANOSECONDS;
+    do{
+      close_status=__atomic_load_n(&log_state_base->close_status,__ATOMIC_ACQUIRE);
+      spawn_log_drain(log_state_base);
+      if(close_status){
+        break;
+      }
+      nanosleep(&timespec,NULL);
+    }while(1);
+    return NULL;
+  }
+#endif
+
+u8
+spawn_log_close(spawn_t *spawn_base){
+/*
+Write out all remaining log records, and close the log. Must not be called while any threads are in flight. The file descriptor is not closed.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+Out:
+
+  Returns 1 if the log was not open, or any write failed, else 0.
+*/
+  spawn_log_state_t *log_state_base;
+  u8 status;
+
+  log_state_base=spawn_base->log_state_base;
+  status=1;
+  if(log_state_base){
+#ifdef PTHREAD
+    __atomic_store_n(&log_state_base->close_status,1,__ATOMIC_RELEASE);
+    while(pthread_join(log_state_base->drainer_pthread,NULL));
+#else
+    spawn_log_drain(log_state_base);
+#endif
+    status=log_state_base->error_status;
+    spawn_free(log_state_base->ring_list_base[0].base);
+    spawn_free(log_state_base->ring_list_base);
+    spawn_free(log_state_base->stage_base);
+    spawn_free(log_state_base);
+    spawn_base->log_state_base=NULL;
+  }
+  return status;
+}
+
+u8
+spawn_log_open(spawn_t *spawn_base,int fd,u8 ring_size_log2,u8 text_status){
+/*
+Open a log, to which threads append records with spawn_log_write() or spawn_log_printf() without taking any locks, unlike printf(), which serializes all threads on the lock of stdout. Each simulthread appends to its own ring buffer, and each record is stamped with the time, thread_idx, and simulthread_idx. In multithreaded mode, a drainer pthread, which is not counted as a simulthread, writes the records to a file descriptor in batches every SPAWN_LOG_DRAIN_NANOSECONDS. In monothreaded mode, they're written whenever the ring fills up, and when the log is closed. Records from the same simulthread appear in the order in which they were appended, but those from different simulthreads are interleaved by batch, so sort by time if a global order is needed. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+  fd is a file descriptor open for writing.
+
+  ring_size_log2 is the log2 of the size of each simulthread's ring, in bytes, at least SPAWN_LOG_RING_SIZE_LOG2_MIN. A thread which appends to a full ring waits for the drainer, so it should hold at least SPAWN_LOG_DRAIN_NANOSECONDS worth of records.
+
+  text_status is 1 to write each record as a line of text consisting of the time in nanoseconds, thread_idx, simulthread_idx, and the payload, separated by spaces, which is appropriate when the payloads are text. Else 0 to write each record as a spawn_log_record_t followed by its payload.
+
+Out:
+
+  Returns 1 on failure due to insufficient memory or an invalid ring_size_log2, or because a log is already open, else 0. spawn_log_close() must eventually be called, after spawn_multi_retire_all().
+*/
+  u8 *base;
+  spawn_log_state_t *log_state_base;
+  u64 ring_list_size;
+  u32 ring_idx;
+  ULONG ring_size;
+  u8 status;
+
+  status=1;
+  ring_size=0;
+  ring_list_size=0;
+  if((SPAWN_LOG_RING_SIZE_LOG2_MIN<=ring_size_log2)&&(ring_size_log2<ULONG_BIT_MAX)){
+    ring_size=(ULONG)(1)<<ring_size_log2;
+    ring_list_size=((u64)(spawn_base->simulthread_idx_max)+1)*ring_size;
+  }
+  if(ring_size&&(ring_list_size<=ULONG_MAX)&&(!spawn_base->log_state_base)){
+    log_state_base=(spawn_log_state_t *)(spawn_malloc(sizeof(spawn_log_state_t)-1));
+    if(log_state_base){
+      log_state_base->ring_list_base=(spawn_log_ring_t *)(spawn_malloc((ULONG)(((spawn_base->simulthread_idx_max+1ULL)*sizeof(spawn_log_ring_t))-1)));
+      base=(u8 *)(spawn_malloc((ULONG)(ring_list_size-1)));
+      log_state_base->stage_size=(ring_size<<1)+sizeof(spawn_log_record_t)+SPAWN_LOG_TEXT_SIZE_MAX+1;
+      log_state_base->stage_base=(u8 *)(spawn_malloc(log_state_base->stage_size-1));
+      if(log_state_base->ring_list_base&&base&&log_state_base->stage_base){
+        ring_idx=0;
+        do{
+          log_state_base->ring_list_base[ring_idx].base=&base[ring_idx*ring_size];
+          log_state_base->ring_list_base[ring_idx].head=0;
+          log_state_base->ring_list_base[ring_idx].tail=0;
+        }while((ring_idx++)!=spawn_base->simulthread_idx_max);
+        log_state_base->ring_size=ring_size;
+        log_state_base->stage_idx=0;
+        log_state_base->ring_idx_max=spawn_base->simulthread_idx_max;
+        log_state_base->fd=fd;
+        log_state_base->close_status=0;
+        log_state_base->error_status=0;
+        log_state_base->text_status=text_status;
+        status=0;
+#ifdef PTHREAD
+        status=!!pthread_create(&log_state_base->drainer_pthread,NULL,spawn_log_drainer,log_state_base);
+#endif
+      }
+      if(!status){
+        spawn_base->log_state_base=log_state_base;
+      }else{
+        spawn_free(base);
+        spawn_free(log_state_base->ring_list_base);
+        spawn_free(log_state_base->stage_base);
+        spawn_free(log_state_base);
+      }
+    }
+  }
+  return status;
+}
+
+u8
+spawn_log_write(spawn_simulthread_context_t *simulthread_context_base,u8 *base,ULONG size){
+/*
+Append a binary record to the log of the calling simulthread, without taking any locks.
+
+In:
+
+  *simulthread_context_base is as passed to the thread.
+
+  base is the base of the payload.
+
+  size is the size of the payload, which may be 0. Together with a spawn_log_record_t, it must fit in a ring, as sized by spawn_log_open().
+
+Out:
+
+  Returns 1 if no log is open or the record is too large, else 0.
+*/
+  u64 head;
+  spawn_log_state_t *log_state_base;
+  spawn_log_record_t record;
+  ULONG record_size;
+  spawn_log_ring_t *ring_base;
+  ULONG ring_size;
+  spawn_t *spawn_base;
+  u8 status;
+  u64 tail;
+
+  spawn_base=(spawn_t *)(((spawn_simulthread_t *)(simulthread_context_base))->spawn_base);
+  log_state_base=spawn_base->log_state_base;
+  status=1;
+  if(log_state_base){
+    ring_size=log_state_base->ring_size;
+    if((size<=(ring_size-sizeof(spawn_log_record_t)))&&(size<=U32_MAX)){
+      status=0;
+      record_size=(ULONG)(sizeof(spawn_log_record_t))+size;
+      ring_base=&log_state_base->ring_list_base[simulthread_context_base->simulthread_idx];
+      tail=ring_base->tail;
+      do{
+        head=__atomic_load_n(&ring_base->head,__ATOMIC_ACQUIRE);
+        if((ring_size-(ULONG)(tail-head))>=record_size){
+          break;
+        }
+/*
+The ring is full, so wait for the drainer, or, in monothreaded mode, be the drainer.
+*/
+#ifdef PTHREAD
+        sched_yield();
+#else
+        spawn_log_drain(log_state_base);
+#endif
+      }while(1);
+      record.nanoseconds=spawn_nanosecond_get();
+      record.thread_idx=simulthread_context_base->thread_idx;
+      record.simulthread_idx=simulthread_context_base->simulthread_idx;
+      record.size=(u32)(size);
+      spawn_log_ring_copy(ring_base->base,ring_size,tail,(u8 *)(&record),sizeof(spawn_log_record_t),0);
+      spawn_log_ring_copy(ring_base->base,ring_size,tail+sizeof(spawn_log_record_t),base,size,0);
+      __atomic_store_n(&ring_base->tail,tail+record_size,__ATOMIC_RELEASE);
+    }
+  }
+  return status;
+}
+
+u8
+spawn_log_printf(spawn_simulthread_context_t *simulthread_context_base,const char *format_base,...){
+/*
+Append a formatted text record to the log of the calling simulthread, without taking any locks. Formatting happens in the calling thread, so it runs in parallel.
+
+In:
+
+  *simulthread_context_base is as passed to the thread.
+
+  format_base and subsequent arguments are as defined for printf(). Text beyond SPAWN_LOG_TEXT_SIZE_MAX bytes is truncated. Don't end it with a newline if the log was opened with text_status 1, which adds one.
+
+Out:
+
+  Returns as defined in spawn_log_write():Out.
+*/
+  va_list arg_list;
+  char text[SPAWN_LOG_TEXT_SIZE_MAX+1];
+  int text_size;
+  u8 status;
+
+  va_start(arg_list,format_base);
+  text_size=vsnprintf(text,sizeof(text),format_base,arg_list);
+  va_end(arg_list);
+  text_size=MIN(MAX(text_size,0),(int)(SPAWN_LOG_TEXT_SIZE_MAX));
+  status=spawn_log_write(simulthread_context_base,(u8 *)(text),(ULONG)(text_size));
+  return status;
+}
+
+void
+spawn_io_ring_free(spawn_io_ring_t *ring_base){
+/*
+Close the io_uring of a simulthread. Do not call from outside Spawn.
+
+In:
+
+  *ring_base is as initialized by spawn_io_ring_init(), whether or not that succeeded.
+
+Out:
+
+  The ring's memory has been unmapped and freed, and its file descriptor closed.
+*/
+  if(ring_base->sqe_list_base){
+    munmap(ring_base->sqe_list_base,(size_t)(ring_base->sqe_list_size));
+  }
+  if(ring_base->cq_map_base){
+    munmap(ring_base->cq_map_base,(size_t)(ring_base->cq_map_size));
+  }
+  if(ring_base->sq_map_base){
+    munmap(ring_base->sq_map_base,(size_t)(ring_base->sq_map_size));
+  }
+  if(0<=ring_base->fd){
+    close(ring_base->fd);
+  }
+  spawn_free(ring_base->completion_list_base);
+  return;
+}
+
+u8
+spawn_io_ring_init(spawn_io_ring_t *ring_base,u32 entry_count,struct iovec *iovec_list_base,u32 iovec_idx_max){
+/*
+Create the io_uring of a simulthread, and register the buffers for fixed operations with it. Do not call from outside Spawn.
+
+In:
+
+  *ring_base is undefined.
+
+  entry_count is the maximum number of operations outstanding at once, which is a power of 2.
+
+  iovec_list_base and iovec_idx_max are as defined in spawn_io_enable():In.
+
+Out:
+
+  Returns 1 on failure, else 0. Either way, *ring_base must be passed to spawn_io_ring_free(). If io_uring is unavailable, for example because the kernel is too old or a seccomp filter forbids it, then this still succeeds, with ring_base->fd set to -1, so that operations run synchronously. If registration fails, then ring_base->fixed_status is 0, and fixed operations run as ordinary ones.
+*/
+#ifdef __linux__
+  int fd;
+  void *map_base;
+  struct io_uring_params params;
+#endif
+  u8 status;
+
+  memset(ring_base,0,sizeof(spawn_io_ring_t));
+  ring_base->fd=-1;
+  ring_base->entry_count=entry_count;
+  status=1;
+  ring_base->completion_list_base=(spawn_io_completion_t *)(spawn_malloc((ULONG)(entry_count*sizeof(spawn_io_completion_t))-1));
+  if(ring_base->completion_list_base){
+    status=0;
+#ifdef __linux__
+    memset(&params,0,sizeof(params));
+    fd=(int)(syscall(__NR_io_uring_setup,entry_count,&params));
+    if(0<=fd){
+      ring_base->fd=fd;
+      ring_base->sq_map_size=(ULONG)(params.sq_off.array+(params.sq_entries*sizeof(u32)));
+      ring_base->cq_map_size=(ULONG)(params.cq_off.cqes+(params.cq_entries*sizeof(struct io_uring_cqe)));
+      ring_base->sqe_list_size=(ULONG)(params.sq_entries*sizeof(struct io_uring_sqe));
+      status=1;
+      map_base=mmap(NULL,(size_t)(ring_base->sq_map_size),PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,fd,IORING_OFF_SQ_RING);
+      if(map_base!=MAP_FAILED){
+        ring_base->sq_map_base=map_base;
+        map_base=mmap(NULL,(size_t)(ring_base->cq_map_size),PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,fd,IORING_OFF_CQ_RING);
+        if(map_base!=MAP_FAILED){
+          ring_base->cq_map_base=map_base;
+          map_base=mmap(NULL,(size_t)(ring_base->sqe_list_size),PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,fd,IORING_OFF_SQES);
+          if(map_base!=MAP_FAILED){
+            ring_base->sqe_list_base=map_base;
+            status=0;
+          }
+        }
+      }
+      if(!status){
+        ring_base->sq_array_base=(u32 *)((u8 *)(ring_base->sq_map_base)+params.sq_off.array);
+        ring_base->sq_tail_base=(u32 *)((u8 *)(ring_base->sq_map_base)+params.sq_off.tail);
+        ring_base->sq_mask=*(u32 *)((u8 *)(ring_base->sq_map_base)+params.sq_off.ring_mask);
+        ring_base->cq_head_base=(u32 *)((u8 *)(ring_base->cq_map_base)+params.cq_off.head);
+        ring_base->cq_tail_base=(u32 *)((u8 *)(ring_base->cq_map_base)+params.cq_off.tail);
+        ring_base->cqe_list_base=(u8 *)(ring_base->cq_map_base)+params.cq_off.cqes;
+        ring_base->cq_mask=*(u32 *)((u8 *)(ring_base->cq_map_base)+params.cq_off.ring_mask);
+        if(iovec_list_base){
+          ring_base->fixed_status=!syscall(__NR_io_uring_register,fd,IORING_REGISTER_BUFFERS,iovec_list_base,iovec_idx_max+1);
+        }
+      }
+    }
+#endif
+  }
+  return status;
+}
+
+void
+spawn_io_free(spawn_t *spawn_base){
+/*
+Close the io_uring instances created by spawn_io_enable(). Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+Out:
+
+  The rings are closed. This is a NOP if they weren't open.
+*/
+  spawn_io_ring_t *io_ring_list_base;
+  u32 simulthread_idx;
+
+  io_ring_list_base=spawn_base->io_ring_list_base;
+  if(io_ring_list_base){
+    simulthread_idx=0;
+    do{
+      spawn_io_ring_free(&io_ring_list_base[simulthread_idx]);
+    }while((simulthread_idx++)!=spawn_base->simulthread_idx_max);
+    spawn_free(io_ring_list_base);
+    spawn_base->io_ring_list_base=NULL;
+  }
+  return;
+}
+
+u8
+spawn_io_enable(spawn_t *spawn_base,u8 queue_size_log2,struct iovec *iovec_list_base,u32 iovec_idx_max){
+/*
+Give each simulthread its own io_uring, so that threads can queue reads and writes with spawn_io_read() and friends, and have them submitted to the kernel in batches with 1 system call, rather than blocking in 1 system call per operation. Operations queued by several thread indexes running back to back on the same simulthread are batched together, for example when a function registered with spawn_prefetch_set() queues the reads of upcoming thread indexes. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+  queue_size_log2 is the log2 of the maximum number of operations which each simulthread may have outstanding at once, at most SPAWN_IO_QUEUE_SIZE_LOG2_MAX.
+
+  iovec_list_base is the base of (iovec_idx_max+1) buffers to register with every ring for spawn_io_read_fixed() and spawn_io_write_fixed(), which saves the kernel from mapping them on every operation, or NULL if there are none. They must remain allocated until spawn_io_free().
+
+  iovec_idx_max is the maximum index into iovec_list_base, if it's not NULL.
+
+Out:
+
+  Returns 1 on failure, else 0. Where io_uring is unavailable, this still succeeds, but operations run synchronously when they're queued. Free the rings with spawn_io_free().
+*/
+  u32 entry_count;
+  spawn_io_ring_t *io_ring_list_base;
+  u32 simulthread_idx;
+  u8 status;
+
+  spawn_io_free(spawn_base);
+  status=1;
+  if(queue_size_log2<=SPAWN_IO_QUEUE_SIZE_LOG2_MAX){
+    io_ring_list_base=(spawn_io_ring_t *)(spawn_malloc((ULONG)((spawn_base->simulthread_idx_max+1ULL)*sizeof(spawn_io_ring_t))-1));
+    if(io_ring_list_base){
+      entry_count=1U<<queue_size_log2;
+      status=0;
+      simulthread_idx=0;
+      do{
+        status=(u8)(status|spawn_io_ring_init(&io_ring_list_base[simulthread_idx],entry_count,iovec_list_base,iovec_idx_max));
+      }while((simulthread_idx++)!=spawn_base->simulthread_idx_max);
+      spawn_base->io_ring_list_base=io_ring_list_base;
+      if(status){
+        spawn_io_free(spawn_base);
+      }
+    }
+  }
+  return status;
+}
+
+spawn_io_ring_t *
+spawn_io_ring_get(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Find the io_uring of the calling simulthread. Do not call from outside Spawn.
+
+In:
+
+  *simulthread_context_base is as passed to the thread.
+
+Out:
+
+  Returns NULL if spawn_io_enable() hasn't been called, else the ring.
+*/
+  spawn_io_ring_t *io_ring_list_base;
+  spawn_t *spawn_base;
+
+  spawn_base=(spawn_t *)(((spawn_simulthread_t *)(simulthread_context_base))->spawn_base);
+  io_ring_list_base=spawn_base->io_ring_list_base;
+  if(io_ring_list_base){
+    io_ring_list_base=&io_ring_list_base[simulthread_context_base->simulthread_idx];
+  }
+  return io_ring_list_base;
+}
+
+u8
+spawn_io_queue(spawn_simulthread_context_t *simulthread_context_base,u8 write_status,int fd,u32 iovec_idx,u8 *base,ULONG size,u64 offset,u64 tag){
+/*
+Queue a read or write on the io_uring of the calling simulthread, without submitting it to the kernel. Do not call from outside Spawn.
+
+In:
+
+  write_status is 1 for a write, else 0 for a read.
+
+  iovec_idx is U32_MAX for an ordinary operation, else the index of the registered buffer which contains base.
+
+  All other inputs are as defined in spawn_io_read():In.
+
+Out:
+
+  Returns as defined in spawn_io_read():Out.
+*/
+  spawn_io_completion_t *completion_base;
+  spawn_io_ring_t *ring_base;
+  ssize_t result;
+#ifdef __linux__
+  struct io_uring_sqe *sqe_base;
+  u32 sqe_idx;
+  u32 sq_tail;
+#endif
+  u8 status;
+
+  status=1;
+  ring_base=spawn_io_ring_get(simulthread_context_base);
+  if(ring_base&&(ring_base->outstanding_count!=ring_base->entry_count)&&(size<=U32_MAX)){
+    status=0;
+    ring_base->outstanding_count++;
+    if(ring_base->fd<0){
+/*
+Without io_uring, do the operation now, and hold its result for spawn_io_wait().
+*/
+      if(write_status){
+        result=pwrite(fd,base,(size_t)(size),(off_t)(offset));
+      }else{
+        result=pread(fd,base,(size_t)(size),(off_t)(offset));
+      }
+      if(result<0){
+        result=-errno;
+      }
+      completion_base=&ring_base->completion_list_base[ring_base->completion_count];
+      completion_base->tag=tag;
+      completion_base->result=(i32)(result);
+      ring_base->completion_count++;
+    }else{
+#ifdef __linux__
+/*
+Only this simulthread writes the tail, so it can be read without synchronization, but it must be published with release semantics so that the kernel sees a complete entry.
+*/
+      sq_tail=*ring_base->sq_tail_base;
+      sqe_idx=sq_tail&ring_base->sq_mask;
+      sqe_base=&((struct io_uring_sqe *)(ring_base->sqe_list_base))[sqe_idx];
+      memset(sqe_base,0,sizeof(struct io_uring_sqe));
+      if(ring_base->fixed_status&&(iovec_idx!=U32_MAX)){
+        sqe_base->opcode=(u8)(write_status?IORING_OP_WRITE_FIXED:IORING_OP_READ_FIXED);
+        sqe_base->buf_index=(u16)(iovec_idx);
+      }else{
+        sqe_base->opcode=(u8)(write_status?IORING_OP_WRITE:IORING_OP_READ);
+      }
+      sqe_base->fd=fd;
+      sqe_base->addr=(u64)((uintptr_t)(base));
+      sqe_base->len=(u32)(size);
+      sqe_base->off=offset;
+      sqe_base->user_data=tag;
+      ring_base->sq_array_base[sqe_idx]=sqe_idx;
+      __atomic_store_n(ring_base->sq_tail_base,sq_tail+1,__ATOMIC_RELEASE);
+      ring_base->pending_count++;
+#endif
+    }
+  }
+  return status;
+}
+
+u8
+spawn_io_read(spawn_simulthread_context_t *simulthread_context_base,int fd,u8 *base,ULONG size,u64 offset,u64 tag){
+/*
+Queue a read on the io_uring of the calling simulthread. It's submitted to the kernel by the next call to spawn_io_submit() or spawn_io_wait() on the same simulthread, whichever comes first. Every operation must be waited for by spawn_io_wait() before the thread which queued it returns, because the kernel cancels the operations of a thread when it exits.
+
+In:
+
+  *simulthread_context_base is as passed to the thread, or to a function registered with spawn_prefetch_set().
+
+  fd is the file descriptor to read.
+
+  base is the base of the buffer to read into, which must remain allocated until the read completes.
+
+  size is the number of bytes to read, at most U32_MAX.
+
+  offset is the offset in the file at which to start.
+
+  tag is any value which identifies the operation to spawn_io_wait(), such as the thread_idx, and is unique among those outstanding on the simulthread.
+
+Out:
+
+  Returns 1 if spawn_io_enable() hasn't been called, the simulthread already has (2^queue_size_log2) operations outstanding, or size is too large, else 0.
+*/
+  u8 status;
+
+  status=spawn_io_queue(simulthread_context_base,0,fd,U32_MAX,base,size,offset,tag);
+  return status;
+}
+
+u8
+spawn_io_read_fixed(spawn_simulthread_context_t *simulthread_context_base,int fd,u32 iovec_idx,u8 *base,ULONG size,u64 offset,u64 tag){
+/*
+Equivalent to spawn_io_read(), except that the buffer lies within one registered by spawn_io_enable(), which saves the kernel from mapping it.
+
+In:
+
+  iovec_idx is the index of the registered buffer which contains base through (base+size-1).
+
+  All other inputs are as defined in spawn_io_read():In.
+
+Out:
+
+  Returns as defined in spawn_io_read():Out.
+*/
+  u8 status;
+
+  status=spawn_io_queue(simulthread_context_base,0,fd,iovec_idx,base,size,offset,tag);
+  return status;
+}
+
+u8
+spawn_io_write(spawn_simulthread_context_t *simulthread_context_base,int fd,u8 *base,ULONG size,u64 offset,u64 tag){
+/*
+Equivalent to spawn_io_read(), except that it writes base through (base+size-1) to the file. The buffer must not be modified until the write completes.
+*/
+  u8 status;
+
+  status=spawn_io_queue(simulthread_context_base,1,fd,U32_MAX,base,size,offset,tag);
+  return status;
+}
+
+u8
+spawn_io_write_fixed(spawn_simulthread_context_t *simulthread_context_base,int fd,u32 iovec_idx,u8 *base,ULONG size,u64 offset,u64 tag){
+/*
+Equivalent to spawn_io_write(), except that the buffer lies within one registered by spawn_io_enable(), as with spawn_io_read_fixed().
+*/
+  u8 status;
+
+  status=spawn_io_queue(simulthread_context_base,1,fd,iovec_idx,base,size,offset,tag);
+  return status;
+}
+
+u8
+spawn_io_enter(spawn_io_ring_t *ring_base,u32 wait_count){
+/*
+Submit all queued operations of a simulthread to the kernel, optionally wait for a completion, and collect whatever completions are available. Do not call from outside Spawn.
+
+In:
+
+  *ring_base is as returned by spawn_io_ring_get(), with ring_base->fd not -1.
+
+  wait_count is 1 to wait until at least 1 completion is available, else 0.
+
+Out:
+
+  Returns 1 on failure, else 0. All available completions have been moved to ring_base->completion_list_base.
+*/
+#ifdef __linux__
+  spawn_io_completion_t *completion_base;
+  struct io_uring_cqe *cqe_base;
+  u32 cq_head;
+  u32 cq_tail;
+  long result;
+#endif
+  u8 status;
+
+  status=0;
+#ifdef __linux__
+  while(ring_base->pending_count||wait_count){
+    result=syscall(__NR_io_uring_enter,ring_base->fd,ring_base->pending_count,wait_count,wait_count?IORING_ENTER_GETEVENTS:0,NULL,0);
+    if(0<=result){
+      ring_base->pending_count-=(u32)(MIN((u64)(result),ring_base->pending_count));
+      break;
+    }else if(errno!=EINTR){
+      status=1;
+      break;
+    }
+  }
+  cq_head=*ring_base->cq_head_base;
+  cq_tail=__atomic_load_n(ring_base->cq_tail_base,__ATOMIC_ACQUIRE);
+  while(cq_head!=cq_tail){
+    cqe_base=&((struct io_uring_cqe *)(ring_base->cqe_list_base))[cq_head&ring_base->cq_mask];
+    completion_base=&ring_base->completion_list_base[ring_base->completion_count];
+    completion_base->tag=cqe_base->user_data;
+    completion_base->result=cqe_base->res;
+    ring_base->completion_count++;
+    cq_head++;
+  }
+  __atomic_store_n(ring_base->cq_head_base,cq_head,__ATOMIC_RELEASE);
+#else
+  status=1;
+#endif
+  return status;
+}
+
+u8
+spawn_io_submit(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Submit the operations queued on the io_uring of the calling simulthread to the kernel, without waiting for any of them. This is only needed to start them sooner than the next spawn_io_wait().
+
+In:
+
+  *simulthread_context_base is as passed to the thread, or to a function registered with spawn_prefetch_set().
+
+Out:
+
+  Returns 1 if spawn_io_enable() hasn't been called, or the submission failed, else 0.
+*/
+  spawn_io_ring_t *ring_base;
+  u8 status;
+
+  status=1;
+  ring_base=spawn_io_ring_get(simulthread_context_base);
+  if(ring_base){
+    status=0;
+    if(0<=ring_base->fd){
+      status=spawn_io_enter(ring_base,0);
+    }
+  }
+  return status;
+}
+
+u8
+spawn_io_wait(spawn_simulthread_context_t *simulthread_context_base,u64 tag,i32 *result_base){
+/*
+Submit the operations queued on the io_uring of the calling simulthread, then wait for the one with a given tag to complete. Completions of other operations which arrive in the meantime are held until they're waited for.
+
+In:
+
+  *simulthread_context_base is as passed to the thread.
+
+  tag is as passed to spawn_io_read() or its siblings.
+
+  *result_base is undefined.
+
+Out:
+
+  Returns 1 if spawn_io_enable() hasn't been called, no operation with the tag is outstanding, or the kernel failed, else 0.
+
+  *result_base is, on success, the number of bytes transferred, or a negated errno value, such as -EBADF, if the operation failed.
+*/
+  spawn_io_completion_t *completion_list_base;
+  u32 completion_idx;
+  spawn_io_ring_t *ring_base;
+  u8 status;
+
+  status=1;
+  ring_base=spawn_io_ring_get(simulthread_context_base);
+  while(ring_base&&ring_base->outstanding_count){
+    completion_list_base=ring_base->completion_list_base;
+    for(completion_idx=0;completion_idx<ring_base->completion_count;completion_idx++){
+      if(completion_list_base[completion_idx].tag==tag){
+        *result_base=completion_list_base[completion_idx].result;
+        ring_base->completion_count--;
+        completion_list_base[completion_idx]=completion_list_base[ring_base->completion_count];
+        ring_base->outstanding_count--;
+        status=0;
+        break;
+      }
+    }
+/*
+Stop if the tag was found, or if every outstanding operation has completed without it.
+*/
+    if((!status)||(ring_base->completion_count==ring_base->outstanding_count)||(ring_base->fd<0)||spawn_io_enter(ring_base,1)){
+      break;
+    }
+  }
+  return status;
+}
+
+void
+spawn_memo_free(spawn_t *spawn_base){
+/*
+Disable memoization and free the cache, if any. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+Out:
+
+  spawn_base->memo_state_base is NULL.
+*/
+  spawn_memo_state_t *memo_state_base;
+
+  memo_state_base=spawn_base->memo_state_base;
+  if(memo_state_base){
+    spawn_free(memo_state_base->cache_list_base);
+    spawn_free(memo_state_base->fingerprint_list_base);
+    spawn_free(memo_state_base->valid_list_base);
+    spawn_free(memo_state_base);
+    spawn_base->memo_state_base=NULL;
+  }
+  return;
+}
+
+void
+spawn_memo_rewind(spawn_t *spawn_base,void (*function_base)(spawn_simulthread_context_t *)){
+/*
+Invalidate all memoized results if the function is about to change, because fingerprints only describe what the threads read, not what they compute. A new readonly_string_base doesn't invalidate anything, because the fingerprints already cover whatever the threads read from it. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(), before its function_base has been changed.
+
+  function_base is as passed to spawn_multi_rewind() or spawn_mono_rewind().
+
+Out:
+
+  If function_base has changed, no result is cached.
+*/
+  spawn_memo_state_t *memo_state_base;
+
+  memo_state_base=spawn_base->memo_state_base;
+  if(memo_state_base&&(spawn_base->function_base!=function_base)){
+    memset(memo_state_base->valid_list_base,0,(size_t)(memo_state_base->thread_idx_max)+1);
+  }
+  return;
+}
+
+u8
+spawn_memo_enable(spawn_t *spawn_base,void (*depend_function_base)(spawn_simulthread_context_t *),u8 *result_list_base,ULONG result_size,ULONG thread_idx_max){
+/*
+Cache the result of each thread_idx, keyed by a fingerprint of the inputs on which it depends, so that after spawn_multi_rewind() or spawn_mono_rewind() with slightly changed inputs, only the threads whose inputs changed are executed again. The others have their cached results copied back instead. The cache persists across rewinds until spawn_memo_free() or another call to this function, except that a rewind to a different function_base empties it. Results of threads which finish while spawn_stop_get() would return 1 aren't cached, because they might be partial.
+
+In:
+
+  depend_function_base is called, on the simulthread, before each thread that would otherwise be executed. It must call spawn_memo_depend() and/or spawn_memo_depend_hash() to describe everything the thread reads, then return. It's passed the same context as the thread itself, so it can see the current readonly_string_base.
+
+  result_list_base is the base of (thread_idx_max+1) results, each of result_size bytes, where each thread writes its result at (result_list_base+(thread_idx*result_size)). Threads must have no other side effects, because they might not be executed.
+
+  result_size is the nonzero size of each thread's result.
+
+  thread_idx_max is the maximum thread_idx to memoize. Greater ones are always executed.
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+Out:
+
+  Returns 1 on failure due to insufficient memory, result_size==0, or an open streaming sink or speculative reexecution, else 0. Any previous cache is discarded.
+*/
+  u64 cache_list_size;
+  spawn_memo_state_t *memo_state_base;
+  u8 status;
+
+  spawn_memo_free(spawn_base);
+  cache_list_size=thread_idx_max;
+  cache_list_size++;
+  cache_list_size*=result_size;
+  status=1;
+  if(result_size&&(!spawn_base->sink_state_base)&&(!spawn_base->speculate_state_base)&&(cache_list_size<=ULONG_MAX)&&(thread_idx_max<(ULONG_MAX>>U64_SIZE_LOG2))){
+    memo_state_base=(spawn_memo_state_t *)(spawn_malloc(sizeof(spawn_memo_state_t)-1));
+    if(memo_state_base){
+      memo_state_base->cache_list_base=spawn_malloc((ULONG)(cache_list_size-1));
+      memo_state_base->fingerprint_list_base=(u64 *)(spawn_malloc((ULONG)((((u64)(thread_idx_max)+1)<<U64_SIZE_LOG2)-1)));
+      memo_state_base->valid_list_base=spawn_malloc(thread_idx_max);
+      if(memo_state_base->cache_list_base&&memo_state_base->fingerprint_list_base&&memo_state_base->valid_list_base){
+        memset(memo_state_base->valid_list_base,0,(size_t)(thread_idx_max)+1);
+        memo_state_base->depend_function_base=depend_function_base;
+        memo_state_base->result_list_base=result_list_base;
+        memo_state_base->hit_count=0;
+        memo_state_base->miss_count=0;
+        memo_state_base->result_size=result_size;
+        memo_state_base->thread_idx_max=thread_idx_max;
+        spawn_base->memo_state_base=memo_state_base;
+        status=0;
+      }else{
+        spawn_free(memo_state_base->cache_list_base);
+        spawn_free(memo_state_base->fingerprint_list_base);
+        spawn_free(memo_state_base->valid_list_base);
+        spawn_free(memo_state_base);
+      }
+    }
+  }
+  return status;
+}
+
+u64
+spawn_memo_mix(u64 fingerprint,u64 value){
+/*
+Mix a value into a fingerprint. Do not call from outside Spawn.
+
+In:
+
+  fingerprint is the fingerprint so far.
+
+  value is the value to mix into it.
+
+Out:
+
+  Returns the new fingerprint.
+*/
+  fingerprint^=value;
+  fingerprint*=0x9E3779B97F4A7C15ULL;
+  fingerprint^=fingerprint>>29;
+  return fingerprint;
+}
+
+void
+spawn_memo_depend(spawn_simulthread_context_t *simulthread_context_base,u8 *base,ULONG size){
+/*
+Declare that the current thread depends on the contents of a memory region. Call only from the depend_function_base passed to spawn_memo_enable().
+
+In:
+
+  *simulthread_context_base is as passed to depend_function_base.
+
+  base is the base of the region.
+
+  size is the size of the region, which may be 0.
+
+Out:
+
+  The region's contents, and its size, have been mixed into the thread's fingerprint.
+*/
+  u64 fingerprint;
+  u8 i;
+  spawn_simulthread_t *simulthread_base;
+  u64 value;
+
+  simulthread_base=(spawn_simulthread_t *)(simulthread_context_base);
+  fingerprint=spawn_memo_mix(simulthread_base->memo_fingerprint,size);
+  while(size>=U64_SIZE){
+    memcpy(&value,base,U64_SIZE);
+    fingerprint=spawn_memo_mix(fingerprint,value);
+    base+=U64_SIZE;
+    size-=U64_SIZE;
+  }
+  if(size){
+    value=0;
+    for(i=0;i<size;i++){
+      value|=(u64)(base[i])<<(i<<3);
+    }
+    fingerprint=spawn_memo_mix(fingerprint,value);
+  }
+  simulthread_base->memo_fingerprint=fingerprint;
+  return;
+}
+
+void
+spawn_memo_depend_hash(spawn_simulthread_context_t *simulthread_context_base,u64 hash){
+/*
+Declare that the current thread depends on an input described by a caller-computed hash, such as a file modification time or a content hash maintained elsewhere. Call only from the depend_function_base passed to spawn_memo_enable().
+
+In:
+
+  *simulthread_context_base is as passed to depend_function_base.
+
+  hash is the hash of the input.
+
+Out:
+
+  hash has been mixed into the thread's fingerprint.
+*/
+  spawn_simulthread_t *simulthread_base;
+
+  simulthread_base=(spawn_simulthread_t *)(simulthread_context_base);
+  simulthread_base->memo_fingerprint=spawn_memo_mix(simulthread_base->memo_fingerprint,hash);
+  return;
+}
+
+void
+spawn_memo_count_get(spawn_t *spawn_base,u64 *hit_count_base,u64 *miss_count_base){
+/*
+Get the number of threads that were skipped because their inputs were unchanged, and the number that were executed, since spawn_memo_enable(). Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(), with memoization enabled.
+
+  *hit_count_base is writable.
+
+  *miss_count_base is writable.
+
+Out:
+
+  *hit_count_base is the number of cache hits.
+
+  *miss_count_base is the number of cache misses.
+*/
+  *hit_count_base=spawn_base->memo_state_base->hit_count;
+  *miss_count_base=spawn_base->memo_state_base->miss_count;
+  return;
+}
+
+u8
+spawn_memo_begin(spawn_memo_state_t *memo_state_base,spawn_simulthread_t *simulthread_base){
+/*
+Fingerprint the inputs of a thread and, if they're unchanged, restore its cached result. Do not call from outside Spawn.
+
+In:
+
+  *memo_state_base is as allocated by spawn_memo_enable().
+
+  *simulthread_base is the simulthread about to run, with context.thread_idx set and not exceeding memo_state_base->thread_idx_max.
+
+Out:
+
+  Returns 1 if the result was restored from the cache, so the thread must not be executed, else 0.
+*/
+  ULONG result_offset;
+  ULONG result_size;
+  u8 status;
+  ULONG thread_idx;
+
+  thread_idx=simulthread_base->context.thread_idx;
+  simulthread_base->memo_fingerprint=spawn_memo_mix(0,thread_idx);
+  memo_state_base->depend_function_base(&simulthread_base->context);
+  status=memo_state_base->valid_list_base[thread_idx]&&(memo_state_base->fingerprint_list_base[thread_idx]==simulthread_base->memo_fingerprint);
+  if(status){
+    result_size=memo_state_base->result_size;
+    result_offset=thread_idx*result_size;
+    memcpy(&memo_state_base->result_list_base[result_offset],&memo_state_base->cache_list_base[result_offset],(size_t)(result_size));
+    __atomic_fetch_add(&memo_state_base->hit_count,1,__ATOMIC_RELAXED);
+  }
+  return status;
+}
+
+void
+spawn_memo_end(spawn_memo_state_t *memo_state_base,spawn_simulthread_t *simulthread_base){
+/*
+Cache the result of a thread which was just executed. Do not call from outside Spawn.
+
+In:
+
+  *memo_state_base is as allocated by spawn_memo_enable().
+
+  *simulthread_base is as passed to spawn_memo_begin(), which returned 0.
+
+Out:
+
+  The result and fingerprint of the thread have been cached.
+*/
+  ULONG result_offset;
+  ULONG result_size;
+  ULONG thread_idx;
+
+  thread_idx=simulthread_base->context.thread_idx;
+  result_size=memo_state_base->result_size;
+  result_offset=thread_idx*result_size;
+  memcpy(&memo_state_base->cache_list_base[result_offset],&memo_state_base->result_list_base[result_offset],(size_t)(result_size));
+  memo_state_base->fingerprint_list_base[thread_idx]=simulthread_base->memo_fingerprint;
+  memo_state_base->valid_list_base[thread_idx]=1;
+  __atomic_fetch_add(&memo_state_base->miss_count,1,__ATOMIC_RELAXED);
+  return;
+}
+
+void
+spawn_prefetch_set(spawn_t *spawn_base,void (*prefetch_function_base)(spawn_simulthread_context_t *,ULONG),u32 prefetch_count){
+/*
+Register a function to be called on each simulthread for the thread indexes which it will run next, while it's still running earlier ones, so that their inputs can be pulled into cache ahead of time, for example with __builtin_prefetch(). This applies to the contiguous ranges of thread indexes which spawn_multi() launches per simulthread while a prefetch function is registered (unless a streaming sink is open), and to the chunks launched by spawn_multi_list() and spawn_multi_bitmap(), as well as their monothreaded equivalents. It doesn't apply to spawn_multi_one(), which has no upcoming thread indexes to look at. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+  prefetch_function_base is called with the context of the simulthread that will run a thread index, and that index, once per index, shortly before the thread itself. It must not modify anything that the thread reads. Every index for which it has been called is also run, even after spawn_stop_set(), so the thread can wait for whatever it started, such as spawn_io_read(). NULL disables prefetching.
+
+  prefetch_count is the number of thread indexes to stay ahead. Something which covers the latency of a cache miss, such as 2 to 8, is usually best.
+
+Out:
+
+  The prefetch function is registered.
+*/
+  if(!prefetch_count){
+    prefetch_function_base=NULL;
+  }
+  spawn_base->prefetch_function_base=prefetch_function_base;
+  spawn_base->prefetch_count=prefetch_count;
+  return;
+}
+
+void
+spawn_stat_free(spawn_t *spawn_base){
+/*
+Stop updating the statistics file created by spawn_stat_enable(). Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+Out:
+
+  The file is unmapped, but left in place with its final contents, so that it can still be read. Delete it with unlink() when it's no longer needed. This is a NOP if statistics weren't enabled.
+*/
+  if(spawn_base->stat_base){
+    munmap(spawn_base->stat_base,(size_t)(spawn_base->stat_size));
+    spawn_base->stat_base=NULL;
+    spawn_base->stat_size=0;
+  }
+  return;
+}
+
+u8
+spawn_stat_enable(spawn_t *spawn_base,char *path_base){
+/*
+Publish live progress and throughput statistics in a file which another process can map and read at any time, without pausing or signalling this one, for example to detect stalls and throughput regressions during a long run. The counters are updated with atomic operations as each thread_idx starts and finishes, so there are no locks. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+  path_base is the path of the file to create or overwrite. Put it under "/dev/shm" so that it lives in memory. See spawn_stat.c for a reader.
+
+Out:
+
+  Returns 1 on failure, else 0. On success, the file contains a spawn_stat_t, with its start time set to now, followed by the busy time of each simulthread. thread_count is increased by the number of thread indexes submitted by each subsequent call to spawn_multi(), spawn_multi_list(), spawn_multi_bitmap(), or spawn_multi_deadline(), or their monothreaded equivalents; the caller must use spawn_stat_total_add() to account for spawn_multi_one() if it wants an ETA. Free it with spawn_stat_free().
+*/
+  int fd;
+  u64 size;
+  spawn_stat_t *stat_base;
+  void *stat_base_void;
+  u8 status;
+
+  spawn_stat_free(spawn_base);
+  status=1;
+  size=spawn_base->simulthread_idx_max;
+  size=(size+1)*sizeof(u64)+sizeof(spawn_stat_t);
+  if(size<=ULONG_MAX){
+    fd=open(path_base,O_RDWR|O_CREAT|O_TRUNC,0644);
+    if(0<=fd){
+      if(!ftruncate(fd,(off_t)(size))){
+        stat_base_void=mmap(NULL,(size_t)(size),PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+        if(stat_base_void!=MAP_FAILED){
+          stat_base=(spawn_stat_t *)(stat_base_void);
+          stat_base->complete_count=0;
+          stat_base->eta_milliseconds=U64_MAX;
+          stat_base->launch_count=0;
+          stat_base->rate_milli=0;
+          stat_base->start_nanoseconds=spawn_nanosecond_get();
+          stat_base->thread_count=0;
+          stat_base->update_nanoseconds=stat_base->start_nanoseconds;
+          stat_base->window_complete_count=0;
+          stat_base->window_nanoseconds=stat_base->start_nanoseconds;
+          stat_base->pid=(u32)(getpid());
+          stat_base->simulthread_idx_max=spawn_base->simulthread_idx_max;
+/*
+Write the signature last, so that a reader never sees a half initialized file as valid.
+*/
+          __atomic_store_n(&stat_base->signature,SPAWN_STAT_SIGNATURE,__ATOMIC_RELEASE);
+          spawn_base->stat_base=stat_base;
+          spawn_base->stat_size=(ULONG)(size);
+          status=0;
+        }
+      }
+      close(fd);
+    }
+  }
+  return status;
+}
+
+void
+spawn_stat_total_add(spawn_t *spawn_base,u64 thread_count){
+/*
+Add to the total number of thread indexes expected to run, on which the ETA is based. This is only needed for thread indexes launched by spawn_multi_one() or spawn_mono_one(), whose total Spawn can't know.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+  thread_count is the number of thread indexes to add.
+
+Out:
+
+  thread_count has been added, if statistics are enabled.
+*/
+  if(spawn_base->stat_base){
+    __atomic_fetch_add(&spawn_base->stat_base->thread_count,thread_count,__ATOMIC_RELAXED);
+  }
+  return;
+}
+
+void
+spawn_stat_plan(spawn_t *spawn_base,ULONG *bitmap_base,ULONG item_idx_max){
+/*
+Add the thread indexes of a submission to the statistics total. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+  bitmap_base is as defined in spawn_multi_bitmap():In, or NULL if the submission is (item_idx_max+1) thread indexes.
+
+  item_idx_max is the maximum bit index if bitmap_base is not NULL, else the maximum thread_idx or list index.
+
+Out:
+
+  The total has been increased, if statistics are enabled.
+*/
+  u64 thread_count;
+  ULONG word;
+  ULONG word_idx;
+  ULONG word_idx_max;
+
+  if(spawn_base->stat_base){
+    thread_count=(u64)(item_idx_max)+1;
+    if(bitmap_base){
+      thread_count=0;
+      word_idx_max=item_idx_max>>ULONG_BITS_LOG2;
+      word_idx=0;
+      do{
+        word=bitmap_base[word_idx];
+        if(word_idx==word_idx_max){
+          word&=(ULONG)(((ULONG)(2)<<(item_idx_max&ULONG_BIT_MAX))-1);
+        }
+        thread_count+=(u64)(__builtin_popcountll((u64)(word)));
+      }while((word_idx++)!=word_idx_max);
+    }
+    spawn_stat_total_add(spawn_base,thread_count);
+  }
+  return;
+}
+
+u64
+spawn_stat_begin(spawn_stat_t *stat_base){
+/*
+Count a thread_idx as launched. Do not call from outside Spawn.
+
+In:
+
+  *stat_base is as created by spawn_stat_enable().
+
+Out:
+
+  Returns the current time, to pass to spawn_stat_end().
+*/
+  __atomic_fetch_add(&stat_base->launch_count,1,__ATOMIC_RELAXED);
+  return spawn_nanosecond_get();
+}
+
+void
+spawn_stat_end(spawn_stat_t *stat_base,u32 simulthread_idx,u64 begin_nanoseconds){
+/*
+Count a thread_idx as complete, charge its time to its simulthread, and, at most once per SPAWN_STAT_WINDOW_NANOSECONDS, update the throughput and ETA. Do not call from outside Spawn.
+
+In:
+
+  *stat_base is as created by spawn_stat_enable().
+
+  simulthread_idx is the simulthread which ran the thread_idx.
+
+  begin_nanoseconds is as returned by spawn_stat_begin().
+
+Out:
+
+  *stat_base is updated.
+*/
+  u64 *busy_list_base;
+  u64 complete_count;
+  u64 complete_delta;
+  u64 eta_milliseconds;
+  u64 nanoseconds;
+  u64 rate_milli;
+  u64 thread_count;
+  u64 window_nanoseconds;
+
+  nanoseconds=spawn_nanosecond_get();
+  busy_list_base=(u64 *)(&stat_base[1]);
+  __atomic_fetch_add(&busy_list_base[simulthread_idx],nanoseconds-begin_nanoseconds,__ATOMIC_RELAXED);
+  complete_count=__atomic_add_fetch(&stat_base->complete_count,1,__ATOMIC_RELAXED);
+  __atomic_store_n(&stat_base->update_nanoseconds,nanoseconds,__ATOMIC_RELAXED);
+  window_nanoseconds=__atomic_load_n(&stat_base->window_nanoseconds,__ATOMIC_RELAXED);
+/*
+Whichever thread wins the race to close the window computes the rate over it.
+*/
+  if(((window_nanoseconds+SPAWN_STAT_WINDOW_NANOSECONDS)<=nanoseconds)&&__atomic_compare_exchange_n(&stat_base->window_nanoseconds,&window_nanoseconds,nanoseconds,0,__ATOMIC_RELAXED,__ATOMIC_RELAXED)){
+    complete_delta=complete_count-__atomic_exchange_n(&stat_base->window_complete_count,complete_count,__ATOMIC_RELAXED);
+    rate_milli=(complete_delta*1000000000ULL)/((nanoseconds-window_nanoseconds)/1000);
+    eta_milliseconds=U64_MAX;
+    thread_count=__atomic_load_n(&stat_base->thread_count,__ATOMIC_RELAXED);
+    if(rate_milli&&(complete_count<=thread_count)){
+      eta_milliseconds=((thread_count-complete_count)*1000000)/rate_milli;
+    }
+    __atomic_store_n(&stat_base->rate_milli,rate_milli,__ATOMIC_RELAXED);
+    __atomic_store_n(&stat_base->eta_milliseconds,eta_milliseconds,__ATOMIC_RELAXED);
+  }
+  return;
+}
+
+u8
+spawn_stop_set(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Cancel the rest of the current submission, for example because this thread has found what a search was looking for. No more thread indexes are launched, including those remaining in chunks of bulk submissions, so that spawn_multi_retire_all() returns as soon as the threads in flight have finished. Those threads see 1 from spawn_stop_get(), and should return early. The cancellation remains in effect until spawn_multi_rewind() or spawn_mono_rewind() is called.
+
+In:
+
+  *simulthread_context_base is as passed to the thread.
+
+Out:
+
+  Returns 0 if this was the first call since the cancellation was last cleared, else 1, so that exactly one thread can claim to have triggered it. A deadline which has passed doesn't count as a call.
+*/
+  spawn_t *spawn_base;
+  u8 status;
+
+  spawn_base=(spawn_t *)(((spawn_simulthread_t *)(simulthread_context_base))->spawn_base);
+  status=__atomic_fetch_or(&spawn_base->stop_status,SPAWN_STOP_SET,__ATOMIC_RELAXED);
+  return (u8)(status&SPAWN_STOP_SET);
+}
+
+u8
+spawn_stop_get(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Find out whether the current thread should wrap up early. Long-running threads should poll this between units of work, and, if it returns 1, save the best result found so far and return.
+
+In:
+
+  *simulthread_context_base is as passed to the thread.
+
+Out:
+
+  Returns 1 if the thread should return as soon as possible, else 0. This is the case when spawn_stop_set() has been called, or when the deadline of spawn_multi_deadline() or spawn_mono_deadline() has passed and wrap_status was 1.
+*/
+  u64 deadline_nanoseconds;
+  spawn_t *spawn_base;
+  u8 status;
+
+  spawn_base=(spawn_t *)(((spawn_simulthread_t *)(simulthread_context_base))->spawn_base);
+  status=__atomic_load_n(&spawn_base->stop_status,__ATOMIC_RELAXED);
+  if((!status)&&spawn_base->deadline_wrap_status){
+    deadline_nanoseconds=spawn_base->deadline_nanoseconds;
+    if(deadline_nanoseconds<=spawn_nanosecond_get()){
+/*
+Mark the stop as caused by the deadline, so that the deadline run can clear it on return without forgetting a call to spawn_stop_set().
+*/
+      __atomic_fetch_or(&spawn_base->stop_status,SPAWN_STOP_DEADLINE,__ATOMIC_RELAXED);
+      status=1;
+    }
+  }
+  return (u8)(!!status);
+}
+
+u8
+spawn_deadline_passed_get(spawn_t *spawn_base){
+/*
+Find out whether the deadline of spawn_multi_deadline() or spawn_mono_deadline() has passed. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+Out:
+
+  Returns 1 if a deadline is in effect and has passed, else 0.
+*/
+  u64 deadline_nanoseconds;
+  u8 status;
+
+  deadline_nanoseconds=spawn_base->deadline_nanoseconds;
+  status=deadline_nanoseconds&&(deadline_nanoseconds<=spawn_nanosecond_get());
+  return status;
+}
+
+void
+spawn_deadline_set(spawn_t *spawn_base,u64 deadline_nanoseconds){
+/*
+Start the deadline of spawn_multi_deadline() or spawn_mono_deadline(). Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init().
+
+  deadline_nanoseconds is the time budget, starting now.
+
+Out:
+
+  spawn_base->deadline_nanoseconds is the time at which the budget runs out, saturated to U64_MAX, which never comes, if the budget is too large to represent.
+*/
+  u64 nanoseconds;
+
+  nanoseconds=spawn_nanosecond_get();
+  spawn_base->deadline_nanoseconds=U64_MAX;
+  if(deadline_nanoseconds<(U64_MAX-nanoseconds)){
+    spawn_base->deadline_nanoseconds=nanoseconds+deadline_nanoseconds;
+  }
+  return;
+}
+
+#ifdef PTHREAD
+  u64
+  spawn_multi_budget_file_limit_get(const char *path_base,u64 limit){
+/*
+Lower a memory limit to the one in a cgroup file, if that's lower. Do not call from outside Spawn.
+
+In:
+
+  path_base is the path of a cgroup v2 memory.max or v1 memory.limit_in_bytes file, which need not exist.
+
+  limit is the limit so far, or 0 if none.
+
+Out:
+
+  Returns the lesser of limit and the limit in the file, treating 0 as no limit.
+*/
+    unsigned long long cgroup_limit;
+    FILE *file_base;
+
+    file_base=fopen(path_base,"r");
+    if(file_base){
+/*
+A cgroup v2 limit of "max" doesn't parse, and a v1 limit of "unlimited" is a huge number, so neither one lowers the limit.
+*/
+      if(fscanf(file_base,"%llu",&cgroup_limit)==1){
+        if(cgroup_limit&&((!limit)||(cgroup_limit<limit))){
+          limit=(u64)(cgroup_limit);
+        }
+      }
+      fclose(file_base);
+    }
+    return limit;
+  }
+
+  u64
+  spawn_multi_budget_limit_get(void){
+/*
+Find out how much memory the process may use, for spawn_multi_budget_set(). Do not call from outside Spawn.
+
+In:
+
+  (None.)
+
+Out:
+
+  Returns 0 on failure, else the lesser of physical memory and the memory limits of the cgroup which contains the process and its ancestors, whether cgroup v2 (memory.max) or v1 (memory.limit_in_bytes), less 1/(2^SPAWN_BUDGET_HEADROOM_SHIFT) of it as headroom for the master thread, thread stacks, and the page cache. The cgroup is found in /proc/self/cgroup, so this works whether or not the process has a private cgroup namespace, provided that its cgroup is visible under /sys/fs/cgroup.
+*/
+    char *cgroup_path_base;
+    char *controller_list_base;
+    const char *file_name_base;
+    FILE *file_base;
+    u64 limit;
+    long page_count;
+    long page_size;
+    char path[PATH_MAX];
+    const char *root_path_base;
+    char *slash_base;
+    char text[PATH_MAX];
+
+    limit=0;
+    page_count=sysconf(_SC_PHYS_PAGES);
+    page_size=sysconf(_SC_PAGESIZE);
+    if((0<page_count)&&(0<page_size)){
+      limit=(u64)(page_count)*(u64)(page_size);
+    }
+    file_base=fopen("/proc/self/cgroup","r");
+    if(file_base){
+/*
+Each line is "hierarchy-ID:controller-list:cgroup-path". The cgroup v2 line has an empty controller list, and the cgroup v1 line of interest lists "memory".
+*/
+      while(fgets(text,(int)(sizeof(text)),file_base)){
+        controller_list_base=strchr(text,':');
+        if(!controller_list_base){
+          continue;
+        }
+        controller_list_base++;
+        cgroup_path_base=strchr(controller_list_base,':');
+        if(!cgroup_path_base){
+          continue;
+        }
+        *cgroup_path_base=0;
+        cgroup_path_base++;
+        cgroup_path_base[strcspn(cgroup_path_base,"\n")]=0;
+        if(!*controller_list_base){
+          file_name_base="memory.max";
+          root_path_base="/sys/fs/cgroup";
+        }else{
+          snprintf(path,sizeof(path),",%s,",controller_list_base);
+          if(!strstr(path,",memory,")){
+            continue;
+          }
+          file_name_base="memory.limit_in_bytes";
+          root_path_base="/sys/fs/cgroup/memory";
+        }
+/*
+A cgroup is also constrained by the limits of its ancestors, so walk up to the root, where the limit file usually doesn't exist.
+*/
+        do{
+          snprintf(path,sizeof(path),"%s%s/%s",root_path_base,(strcmp(cgroup_path_base,"/")?cgroup_path_base:""),file_name_base);
+          limit=spawn_multi_budget_file_limit_get(path,limit);
+          slash_base=strrchr(cgroup_path_base,'/');
+          if((!slash_base)||!strcmp(cgroup_path_base,"/")){
+            break;
+          }
+          if(slash_base==cgroup_path_base){
+            slash_base++;
+          }
+          *slash_base=0;
+        }while(1);
+      }
+      fclose(file_base);
+    }
+    limit-=limit>>SPAWN_BUDGET_HEADROOM_SHIFT;
+    return limit;
+  }
+
+  void
+  spawn_multi_budget_free(spawn_t *spawn_base){
+/*
+Stop admission control and free its state. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  Admission control is off. This is a NOP if it wasn't on.
+*/
+    spawn_budget_state_t *budget_state_base;
+
+    budget_state_base=spawn_base->budget_state_base;
+    if(budget_state_base){
+      pthread_cond_destroy(&budget_state_base->cond);
+      pthread_mutex_destroy(&budget_state_base->mutex);
+      spawn_free(budget_state_base);
+      spawn_base->budget_state_base=NULL;
+    }
+    return;
+  }
+
+  u8
+  spawn_multi_budget_set(spawn_t *spawn_base,u64 (*estimate_function_base)(spawn_simulthread_context_t *),u64 budget_size){
+/*
+Admit thread indexes to run only while the sum of their estimated peak memory footprints fits in a budget, so that several large ones landing at once don't exhaust memory. A thread whose estimate doesn't fit waits, already launched, before its target function is called, and later ones wait behind it in the order in which they arrived, so that a large one isn't starved by a stream of small ones. A thread whose estimate exceeds the entire budget is admitted once nothing else is running. Applies to every way of launching threads, including bulk submissions, where each thread index in a chunk is admitted individually. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init().
+
+  estimate_function_base is called with the context of each thread, including its thread_idx, just before its target function would be, and returns the most memory that the target function will have allocated at once, in bytes. NULL turns admission control off.
+
+  budget_size is the most memory, in bytes, that all running target functions together may have allocated at once, or 0 to derive it from the cgroup memory limit, or physical memory if there isn't one.
+
+Out:
+
+  Returns 1 on failure, else 0. On failure, admission control is off.
+*/
+    spawn_budget_state_t *budget_state_base;
+    u8 status;
+
+    status=0;
+    budget_state_base=spawn_base->budget_state_base;
+    if(estimate_function_base){
+      if(!budget_size){
+        budget_size=spawn_multi_budget_limit_get();
+      }
+      status=!budget_size;
+      if((!status)&&(!budget_state_base)){
+        status=1;
+        budget_state_base=(spawn_budget_state_t *)(spawn_malloc(sizeof(spawn_budget_state_t)-1));
+        if(budget_state_base){
+          status=!!pthread_mutex_init(&budget_state_base->mutex,NULL);
+          if(!status){
+            status=!!pthread_cond_init(&budget_state_base->cond,NULL);
+            if(status){
+              pthread_mutex_destroy(&budget_state_base->mutex);
+            }
+          }
+          if(status){
+            spawn_free(budget_state_base);
+          }else{
+            spawn_base->budget_state_base=budget_state_base;
+          }
+        }
+      }
+      if(!status){
+        budget_state_base->estimate_function_base=estimate_function_base;
+        budget_state_base->budget_size=budget_size;
+        budget_state_base->ticket_idx=0;
+        budget_state_base->turn_idx=0;
+        budget_state_base->used_size=0;
+      }
+    }
+    if(status||!estimate_function_base){
+      spawn_multi_budget_free(spawn_base);
+    }
+    return status;
+  }
+
+  u64
+  spawn_multi_budget_admit(spawn_budget_state_t *budget_state_base,spawn_simulthread_t *simulthread_base){
+/*
+Wait until a thread's estimated memory footprint fits in the budget, and reserve it. Do not call from outside Spawn.
+
+In:
+
+  *budget_state_base is as allocated by spawn_multi_budget_set().
+
+  *simulthread_base is the simulthread about to call its target function.
+
+Out:
+
+  Returns the size reserved, which must be passed to spawn_multi_budget_release() after the target function returns.
+*/
+    u64 budget_size;
+    u64 size;
+    u64 ticket_idx;
+    u64 used_size;
+
+    size=budget_state_base->estimate_function_base(&simulthread_base->context);
+    budget_size=budget_state_base->budget_size;
+    pthread_mutex_lock(&budget_state_base->mutex);
+    ticket_idx=budget_state_base->ticket_idx;
+    budget_state_base->ticket_idx=ticket_idx+1;
+    do{
+      if(ticket_idx==budget_state_base->turn_idx){
+        used_size=budget_state_base->used_size;
+        if((!used_size)||((used_size<=budget_size)&&(size<=(budget_size-used_size)))){
+          break;
+        }
+      }
+      pthread_cond_wait(&budget_state_base->cond,&budget_state_base->mutex);
+    }while(1);
+    budget_state_base->used_size+=size;
+    budget_state_base->turn_idx=ticket_idx+1;
+/*
+The next thread in line might fit as well.
+*/
+    pthread_cond_broadcast(&budget_state_base->cond);
+    pthread_mutex_unlock(&budget_state_base->mutex);
+    return size;
+  }
+
+  void
+  spawn_multi_budget_release(spawn_budget_state_t *budget_state_base,u64 size){
+/*
+Return memory reserved by spawn_multi_budget_admit() to the budget. Do not call from outside Spawn.
+
+In:
+
+  *budget_state_base is as passed to spawn_multi_budget_admit().
+
+  size is as returned by spawn_multi_budget_admit().
+
+Out:
+
+  The memory is back in the budget, and any waiting threads have been woken up to check whether they now fit.
+*/
+    pthread_mutex_lock(&budget_state_base->mutex);
+    budget_state_base->used_size-=size;
+    pthread_cond_broadcast(&budget_state_base->cond);
+    pthread_mutex_unlock(&budget_state_base->mutex);
+    return;
+  }
+#endif
+
+void
+spawn_simulthread_task_execute(spawn_t *spawn_base,spawn_simulthread_t *simulthread_base){
+/*
+Invoke function_base for one thread_idx, wrapped in whatever per-thread instrumentation is enabled. This is the only place where Spawn calls function_base. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is the (spawn_t) which owns *simulthread_base.
+
+  *simulthread_base is the simulthread on which to run, with context.thread_idx set.
+
+Out:
+
+  function_base has been called, or its result restored from the memoization cache.
+*/
+#ifdef PTHREAD
+  u64 budget_size;
+  spawn_budget_state_t *budget_state_base;
+#endif
+  ULONG *done_bitmap_base;
+  u8 memo_hit_status;
+  spawn_memo_state_t *memo_state_base;
+  spawn_perf_state_t *perf_state_base;
+  spawn_sink_state_t *sink_state_base;
+  spawn_stat_t *stat_base;
+  u64 stat_begin_nanoseconds;
+  ULONG thread_idx;
+
+  stat_begin_nanoseconds=0;
+  stat_base=spawn_base->stat_base;
+  if(stat_base){
+    stat_begin_nanoseconds=spawn_stat_begin(stat_base);
+  }
+  sink_state_base=spawn_base->sink_state_base;
+  if(sink_state_base){
+    spawn_sink_begin(sink_state_base,simulthread_base);
+  }
+  thread_idx=simulthread_base->context.thread_idx;
+  memo_hit_status=0;
+  memo_state_base=spawn_base->memo_state_base;
+  if(memo_state_base&&(thread_idx<=memo_state_base->thread_idx_max)){
+    memo_hit_status=spawn_memo_begin(memo_state_base,simulthread_base);
+  }else{
+    memo_state_base=NULL;
+  }
+  if(!memo_hit_status){
+#ifdef PTHREAD
+    budget_size=0;
+    budget_state_base=spawn_base->budget_state_base;
+    if(budget_state_base){
+      budget_size=spawn_multi_budget_admit(budget_state_base,simulthread_base);
+    }
+#endif
+    perf_state_base=spawn_base->perf_state_base;
+    if(perf_state_base){
+      spawn_perf_begin(perf_state_base,simulthread_base);
+    }
+    spawn_base->function_base(&simulthread_base->context);
+    if(perf_state_base){
+      spawn_perf_end(perf_state_base,simulthread_base,thread_idx);
+    }
+#ifdef PTHREAD
+    if(budget_state_base){
+      spawn_multi_budget_release(budget_state_base,budget_size);
+    }
+#endif
+/*
+Don't cache a result which might be partial because the thread was asked to stop early, whether by spawn_stop_set() or by a deadline.
+*/
+    if(memo_state_base&&!__atomic_load_n(&spawn_base->stop_status,__ATOMIC_RELAXED)){
+      spawn_memo_end(memo_state_base,simulthread_base);
+    }
+  }
+  done_bitmap_base=spawn_base->done_bitmap_base;
+  if(done_bitmap_base){
+    __atomic_fetch_or(&done_bitmap_base[thread_idx>>ULONG_BITS_LOG2],(ULONG)(1)<<(thread_idx&ULONG_BIT_MAX),__ATOMIC_RELAXED);
+  }
+  if(sink_state_base){
+    spawn_sink_end(sink_state_base,simulthread_base);
+  }
+  if(stat_base){
+    spawn_stat_end(stat_base,simulthread_base->context.simulthread_idx,stat_begin_nanoseconds);
+  }
+  return;
+}
+
+int
+spawn_bulk_compare(const void *idx_base0,const void *idx_base1){
+/*
+Compare 2 thread indexes for qsort(). Do not call from outside Spawn.
+*/
+  ULONG idx0;
+  ULONG idx1;
+
+  idx0=*(const ULONG *)(idx_base0);
+  idx1=*(const ULONG *)(idx_base1);
+  return (idx0>idx1)-(idx0<idx1);
+}
+
+u8
+spawn_bulk_next(spawn_t *spawn_base,ULONG *item_idx_base,ULONG item_idx_max,ULONG *thread_idx_base){
+/*
+Find the next thread_idx in a chunk of a bulk submission. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is as defined in spawn_bulk_execute():In.
+
+  *item_idx_base is the index of the next item to examine, which is a list index, a bit index, or the thread_idx itself, depending on whether bulk_idx_list_base, bulk_bitmap_base, or neither is set.
+
+  item_idx_max is the maximum item index in the chunk.
+
+  *thread_idx_base is writable.
+
+Out:
+
+  Returns 1 if the chunk is exhausted, else 0.
+
+  *item_idx_base is the index of the item after the one found, if the return value is 0.
+
+  *thread_idx_base is the thread_idx found, if the return value is 0.
+*/
+  ULONG *bitmap_base;
+  ULONG item_idx;
+  u8 status;
+  ULONG word;
+
+  item_idx=*item_idx_base;
+  bitmap_base=spawn_base->bulk_bitmap_base;
+  if(bitmap_base){
+/*
+Skip clear words whole, then clear bits one at a time.
+*/
+    while(item_idx<=item_idx_max){
+      word=bitmap_base[item_idx>>ULONG_BITS_LOG2]>>(item_idx&ULONG_BIT_MAX);
+      if(!word){
+        item_idx=(item_idx|ULONG_BIT_MAX)+1;
+        continue;
+      }
+      while(!(word&1)){
+        word>>=1;
+        item_idx++;
+      }
+      break;
+    }
+  }
+  status=(item_idx>item_idx_max);
+  if(!status){
+    *thread_idx_base=item_idx;
+    if(spawn_base->bulk_idx_list_base){
+      *thread_idx_base=spawn_base->bulk_idx_list_base[item_idx];
+    }
+    *item_idx_base=item_idx+1;
+  }
+  return status;
+}
+
+void
+spawn_bulk_execute(spawn_t *spawn_base,spawn_simulthread_t *simulthread_base){
+/*
+Run every thread_idx in one chunk of a bulk submission, one after another, calling the prefetch function, if any, a fixed distance ahead. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is the (spawn_t) which owns *simulthread_base, with a bulk submission in progress.
+
+  *simulthread_base is the simulthread on which to run, with context.thread_idx set to the chunk index.
+
+Out:
+
+  Every thread_idx in the chunk has been run by spawn_simulthread_task_execute().
+*/
+  ULONG chunk_item_count;
+  ULONG item_idx;
+  ULONG item_idx_max;
+  ULONG item_prefetch_idx;
+  u32 prefetch_count;
+  void (*prefetch_function_base)(spawn_simulthread_context_t *,ULONG);
+  u32 prefetch_pending_count;
+  u8 stop_status;
+  ULONG thread_idx;
+  ULONG thread_prefetch_idx;
+
+  chunk_item_count=spawn_base->bulk_chunk_item_count;
+  item_idx=simulthread_base->context.thread_idx*chunk_item_count;
+  item_idx_max=MIN(spawn_base->bulk_item_idx_max-item_idx,chunk_item_count-1)+item_idx;
+  item_prefetch_idx=item_idx;
+  prefetch_pending_count=0;
+  prefetch_function_base=spawn_base->prefetch_function_base;
+  if(prefetch_function_base){
+/*
+Prime the pipeline, so that the prefetch function stays prefetch_count thread indexes ahead.
+*/
+    prefetch_count=spawn_base->prefetch_count;
+    while(prefetch_count&&!spawn_bulk_next(spawn_base,&item_prefetch_idx,item_idx_max,&thread_prefetch_idx)){
+      prefetch_function_base(&simulthread_base->context,thread_prefetch_idx);
+      prefetch_count--;
+      prefetch_pending_count++;
+    }
+  }
+  do{
+/*
+After a stop, run only the indexes which have already been prefetched, so that whatever the prefetch function started, such as spawn_io_read(), is waited for by the thread which owns it, rather than abandoned on this simulthread.
+*/
+    stop_status=__atomic_load_n(&spawn_base->stop_status,__ATOMIC_RELAXED);
+    if((stop_status&&!prefetch_pending_count)||spawn_bulk_next(spawn_base,&item_idx,item_idx_max,&thread_idx)){
+      break;
+    }
+    if(prefetch_function_base&&(!stop_status)&&!spawn_bulk_next(spawn_base,&item_prefetch_idx,item_idx_max,&thread_prefetch_idx)){
+      prefetch_function_base(&simulthread_base->context,thread_prefetch_idx);
+      prefetch_pending_count++;
+    }
+    if(prefetch_pending_count){
+      prefetch_pending_count--;
+    }
+    simulthread_base->context.thread_idx=thread_idx;
+    spawn_simulthread_task_execute(spawn_base,simulthread_base);
+  }while(1);
+  return;
+}
+
+#ifdef PTHREAD
+  spawn_share_t *
+  spawn_multi_share_init(u32 slot_idx_max,u32 job_idx_max){
+/*
+Create a pool of thread slots to be shared fairly among several (spawn_t)s running in the same process ("jobs"), so that none of them can starve the others of CPUs.
+
+In:
+
+  slot_idx_max is 1 less than the number of threads which may be in flight across all jobs, typically the number of CPUs less 1.
+
+  job_idx_max is 1 less than the maximum number of jobs which may be joined at once.
+
+Out:
+
+  Returns NULL on failure, else a (spawn_share_t *) for use with spawn_multi_share_join(). Free it with spawn_multi_share_free() after all jobs have left.
+*/
+    u64 job_list_size;
+    spawn_share_t *share_base;
+    u8 status;
+
+    status=1;
+    job_list_size=job_idx_max;
+    job_list_size++;
+    job_list_size*=sizeof(spawn_share_job_t);
+    share_base=NULL;
+    if(job_list_size<=ULONG_MAX){
+      share_base=(spawn_share_t *)(spawn_malloc(sizeof(spawn_share_t)-1));
+    }
+    if(share_base){
+      share_base->job_list_base=(spawn_share_job_t *)(spawn_malloc((ULONG)(job_list_size-1)));
+      if(share_base->job_list_base){
+        memset(share_base->job_list_base,0,(size_t)(job_list_size));
+        share_base->job_idx_max=job_idx_max;
+        share_base->slot_free_count=slot_idx_max+1;
+        if(!share_base->slot_free_count){
+          share_base->slot_free_count=U32_MAX;
+        }
+        status=!!pthread_mutex_init(&share_base->mutex,NULL);
+        if(!status){
+          status=!!pthread_cond_init(&share_base->cond,NULL);
+          if(status){
+            pthread_mutex_destroy(&share_base->mutex);
+          }
+        }
+      }
+      if(status){
+        spawn_free(share_base->job_list_base);
+        spawn_free(share_base);
+        share_base=NULL;
+      }
+    }
+    return share_base;
+  }
+
+  void
+  spawn_multi_share_free(spawn_share_t *share_base){
+/*
+Free a pool created by spawn_multi_share_init(). All jobs must have left it.
+
+In:
+
+  share_base is as returned by spawn_multi_share_init(). May be NULL.
+
+Out:
+
+  *share_base is freed.
+*/
+    if(share_base){
+      pthread_cond_destroy(&share_base->cond);
+      pthread_mutex_destroy(&share_base->mutex);
+      spawn_free(share_base->job_list_base);
+      spawn_free(share_base);
+    }
+    return;
+  }
+
+  u8
+  spawn_multi_share_join(spawn_share_t *share_base,spawn_t *spawn_base,u32 weight,u32 share_min,u32 share_max){
+/*
+Make a (spawn_t) draw its threads from a shared pool. Whenever a slot becomes free and several jobs are waiting for one, it goes to a job which has fewer threads in flight than its minimum share, if any, or else to the job with the fewest threads in flight per unit of weight. A job's threads also remain limited by its own simulthread_idx_max. Must not be called while any threads are in flight.
+
+In:
+
+  *share_base is as returned by spawn_multi_share_init().
+
+  *spawn_base is as returned by spawn_multi_init(), and isn't already in a pool.
+
+  weight is the nonzero relative weight of this job.
+
+  share_min is the number of threads in flight below which this job takes priority over jobs at or above their own minimum shares, or 0 for none.
+
+  share_max is the maximum number of threads that this job may have in flight, or 0 for no limit.
+
+Out:
+
+  Returns 1 if the pool is full or weight is 0, else 0.
+*/
+    spawn_share_job_t *job_base;
+    u32 job_idx;
+    u8 status;
+
+    status=1;
+    if(weight){
+      pthread_mutex_lock(&share_base->mutex);
+      job_idx=0;
+      do{
+        job_base=&share_base->job_list_base[job_idx];
+        if(!job_base->spawn_base){
+          job_base->spawn_base=spawn_base;
+          job_base->flight_count=0;
+          job_base->share_max=share_max?share_max:U32_MAX;
+          job_base->share_min=share_min;
+          job_base->waiting_count=0;
+          job_base->weight=weight;
+          spawn_base->share_base=share_base;
+          spawn_base->share_job_idx=job_idx;
+          status=0;
+          break;
+        }
+      }while((job_idx++)!=share_base->job_idx_max);
+      pthread_mutex_unlock(&share_base->mutex);
+    }
+    return status;
+  }
+
+  void
+  spawn_multi_share_leave(spawn_t *spawn_base){
+/*
+Remove a (spawn_t) from its pool, if any. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  *spawn_base no longer draws threads from a pool.
+*/
+    spawn_share_t *share_base;
+
+    share_base=spawn_base->share_base;
+    if(share_base){
+      pthread_mutex_lock(&share_base->mutex);
+      share_base->job_list_base[spawn_base->share_job_idx].spawn_base=NULL;
+      pthread_cond_broadcast(&share_base->cond);
+      pthread_mutex_unlock(&share_base->mutex);
+      spawn_base->share_base=NULL;
+    }
+    return;
+  }
+
+  void
+  spawn_multi_share_acquire(spawn_t *spawn_base){
+/*
+Wait until the pool grants this job a slot. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init(), and in a pool.
+
+Out:
+
+  The job holds one more slot, which must be released by spawn_multi_share_release().
+*/
+    spawn_share_job_t *job_base;
+    u32 job_best_idx;
+    spawn_share_job_t *job_best_base;
+    u8 job_best_priority_status;
+    u32 job_idx;
+    spawn_share_job_t *job_list_base;
+    u8 job_priority_status;
+    spawn_share_t *share_base;
+
+    share_base=spawn_base->share_base;
+    job_list_base=share_base->job_list_base;
+    pthread_mutex_lock(&share_base->mutex);
+    job_list_base[spawn_base->share_job_idx].waiting_count++;
+    do{
+      job_best_idx=U32_MAX;
+      if(share_base->slot_free_count){
+/*
+Pick the waiting job which is furthest below its fair share.
+*/
+        job_best_base=NULL;
+        job_best_priority_status=0;
+        job_idx=0;
+        do{
+          job_base=&job_list_base[job_idx];
+          if(job_base->spawn_base&&job_base->waiting_count&&(job_base->flight_count<job_base->share_max)){
+            job_priority_status=(job_base->flight_count<job_base->share_min);
+            if((!job_best_base)||(job_best_priority_status<job_priority_status)||((job_best_priority_status==job_priority_status)&&(((u64)(job_base->flight_count)*job_best_base->weight)<((u64)(job_best_base->flight_count)*job_base->weight)))){
+              job_best_base=job_base;
+              job_best_idx=job_idx;
+              job_best_priority_status=job_priority_status;
+            }
+          }
+        }while((job_idx++)!=share_base->job_idx_max);
+      }
+      if(job_best_idx==spawn_base->share_job_idx){
+        break;
+      }
+      pthread_cond_wait(&share_base->cond,&share_base->mutex);
+    }while(1);
+    job_base=&job_list_base[job_best_idx];
+    job_base->waiting_count--;
+    job_base->flight_count++;
+    share_base->slot_free_count--;
+/*
+Another job might be next in line for a remaining free slot.
+*/
+    if(share_base->slot_free_count){
+      pthread_cond_broadcast(&share_base->cond);
+    }
+    pthread_mutex_unlock(&share_base->mutex);
+    return;
+  }
+
+  void
+  spawn_multi_share_release(spawn_t *spawn_base){
+/*
+Return a slot granted by spawn_multi_share_acquire() to the pool. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is as passed to spawn_multi_share_acquire().
+
+Out:
+
+  The slot is free, and any waiting jobs have been woken up to compete for it.
+*/
+    spawn_share_t *share_base;
+
+    share_base=spawn_base->share_base;
+    pthread_mutex_lock(&share_base->mutex);
+    share_base->job_list_base[spawn_base->share_job_idx].flight_count--;
+    share_base->slot_free_count++;
+    pthread_cond_broadcast(&share_base->cond);
+    pthread_mutex_unlock(&share_base->mutex);
+    return;
+  }
+#endif
+
+void *
+spawn_simulthread_execute(void *simulthread_context_base){
+/*
+Run a simulthread which was just launched, either for a single thread_idx or for a chunk of a bulk submission, followed by whatever per-launch bookkeeping is enabled on its (spawn_t). Do not call from outside Spawn.
+
+In:
+
+  simulthread_context_base is the base of spawn_simulthread_t.context, which is the first member of its spawn_simulthread_t.
+
+Out:
+
+  Returns NULL, for compatibility with pthread_create().
+*/
+  spawn_simulthread_t *simulthread_base;
+  spawn_speculate_state_t *speculate_state_base;
+  spawn_t *spawn_base;
+
+  simulthread_base=(spawn_simulthread_t *)(simulthread_context_base);
+  spawn_base=(spawn_t *)(simulthread_base->spawn_base);
+  if(spawn_base->bulk_chunk_item_count){
+    spawn_bulk_execute(spawn_base,simulthread_base);
+  }else{
+    spawn_simulthread_task_execute(spawn_base,simulthread_base);
+  }
+#ifdef PTHREAD
+/*
+The performance counters only count this pthread, which is about to exit, so close them before the simulthread can be reused.
+*/
+  spawn_perf_close(simulthread_base);
+  if(simulthread_base->locality_status){
+    __atomic_fetch_sub(&spawn_base->locality_state_base->flight_count_list_base[simulthread_base->locality_domain_idx],1,__ATOMIC_RELAXED);
+  }
+  if(spawn_base->share_base){
+    spawn_multi_share_release(spawn_base);
+  }
+#endif
+  speculate_state_base=spawn_base->speculate_state_base;
+  if(speculate_state_base){
+    spawn_speculate_commit(speculate_state_base,simulthread_base);
+  }
+  return NULL;
+}
+#ifdef PTHREAD
+  void
+  spawn_multi_pthread_join(spawn_simulthread_t *simulthread_base){
+/*
+Force pthread_join() to succeed, or don't return. Do not call from outside Spawn.
+
+In:
+
+  simulthread_base->pthread corresponds to the simulthread to be flushed.
+
+Out:
+
+  The indicated simulthread has flushed successfully.
+*/
+   int pthread_status;
+
+    do{
+      pthread_status=pthread_join(simulthread_base->pthread,NULL);
+/*
+No matter what, do not exit this loop until the pthread_join has succeeded. If we hang, we hang. Better that, than corrupting memory and risking uncontrolled OS calls due to freeing memory in use by another thread.
+*/
+    }while(pthread_status);
+    return;
+  }
+
+  u8
+  spawn_multi_locality_cpu_set_get(u32 cpu_idx,cpu_set_t *cpu_set_base){
+/*
+Find the set of CPUs which share the last level cache with a given CPU, according to sysfs. Do not call from outside Spawn.
+
+In:
+
+  cpu_idx is the index of the CPU.
+
+  *cpu_set_base is writable.
+
+Out:
+
+  Returns 1 if the cache topology is unavailable, else 0.
+
+  *cpu_set_base is the set of CPUs sharing the last level cache with CPU cpu_idx, including itself, if the return value is 0.
+*/
+    u32 cache_idx;
+    u32 cache_level;
+    u32 cache_level_max;
+    u32 cpu_idx_max;
+    u32 cpu_idx_min;
+    char *digit_base;
+    FILE *file_base;
+    char path[128];
+    char text[1024];
+    u8 status;
+
+    cache_level_max=0;
+    status=1;
+    text[0]=0;
+    for(cache_idx=0;cache_idx<=SPAWN_LOCALITY_CACHE_IDX_MAX;cache_idx++){
+      snprintf(path,sizeof(path),"/sys/devices/system/cpu/cpu%u/cache/index%u/level",cpu_idx,cache_idx);
+      file_base=fopen(path,"r");
+      if(!file_base){
+        continue;
+      }
+      cache_level=0;
+      if(fscanf(file_base,"%u",&cache_level)!=1){
+        cache_level=0;
+      }
+      fclose(file_base);
+      if(cache_level>cache_level_max){
+        snprintf(path,sizeof(path),"/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list",cpu_idx,cache_idx);
+        file_base=fopen(path,"r");
+        if(file_base){
+          if(fgets(text,(int)(sizeof(text)),file_base)){
+            cache_level_max=cache_level;
+            status=0;
+          }
+          fclose(file_base);
+        }
+      }
+    }
+    if(!status){
+/*
+Parse a list such as "0-3,8-11".
+*/
+      CPU_ZERO(cpu_set_base);
+      digit_base=text;
+      while((*digit_base>='0')&&(*digit_base<='9')){
+        cpu_idx_min=(u32)(strtoul(digit_base,&digit_base,10));
+        cpu_idx_max=cpu_idx_min;
+        if(*digit_base=='-'){
+          digit_base++;
+          cpu_idx_max=(u32)(strtoul(digit_base,&digit_base,10));
+        }
+        while((cpu_idx_min<=cpu_idx_max)&&(cpu_idx_min<CPU_SETSIZE)){
+          CPU_SET(cpu_idx_min,cpu_set_base);
+          cpu_idx_min++;
+        }
+        if(*digit_base==','){
+          digit_base++;
+        }
+      }
+      status=!CPU_ISSET(cpu_idx,cpu_set_base);
+    }
+    return status;
+  }
+
+  void
+  spawn_multi_locality_free(spawn_t *spawn_base){
+/*
+Disable locality keys and free their storage, if any. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  spawn_base->locality_state_base is NULL.
+*/
+    spawn_locality_state_t *locality_state_base;
+
+    locality_state_base=spawn_base->locality_state_base;
+    if(locality_state_base){
+      spawn_free(locality_state_base->cpu_count_list_base);
+      spawn_free(locality_state_base->cpu_set_list_base);
+      spawn_free(locality_state_base->flight_count_list_base);
+      spawn_free(locality_state_base);
+      spawn_base->locality_state_base=NULL;
+    }
+    return;
+  }
+
+  u8
+  spawn_multi_locality_enable(spawn_t *spawn_base){
+/*
+Discover which CPUs share each last level cache ("cache domains"), so that spawn_multi_one_keyed() can send threads with the same locality key to the same cache domain. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  Returns 1 on failure due to insufficient memory, else 0. If the cache topology can't be discovered, or there's only one cache domain, then success is returned but locality keys are ignored, as they are in monothreaded mode.
+*/
+    u32 cpu_count;
+    cpu_set_t cpu_set;
+    u32 cpu_idx;
+    u32 domain_count;
+    u32 domain_idx;
+    spawn_locality_state_t *locality_state_base;
+    long processor_count;
+    u8 status;
+
+    spawn_multi_locality_free(spawn_base);
+    processor_count=sysconf(_SC_NPROCESSORS_CONF);
+    cpu_count=(u32)(MIN(MAX(processor_count,1),CPU_SETSIZE));
+    status=1;
+    locality_state_base=(spawn_locality_state_t *)(spawn_malloc(sizeof(spawn_locality_state_t)-1));
+    if(locality_state_base){
+/*
+There can't be more cache domains than CPUs.
+*/
+      locality_state_base->cpu_count_list_base=(u32 *)(spawn_malloc((cpu_count<<U32_SIZE_LOG2)-1));
+      locality_state_base->cpu_set_list_base=(cpu_set_t *)(spawn_malloc((ULONG)((cpu_count*sizeof(cpu_set_t))-1)));
+      locality_state_base->flight_count_list_base=(u32 *)(spawn_malloc((cpu_count<<U32_SIZE_LOG2)-1));
+      spawn_base->locality_state_base=locality_state_base;
+      if(locality_state_base->cpu_count_list_base&&locality_state_base->cpu_set_list_base&&locality_state_base->flight_count_list_base){
+        status=0;
+        domain_count=0;
+        for(cpu_idx=0;cpu_idx<cpu_count;cpu_idx++){
+          if(spawn_multi_locality_cpu_set_get(cpu_idx,&cpu_set)){
+            continue;
+          }
+          for(domain_idx=0;domain_idx<domain_count;domain_idx++){
+            if(CPU_EQUAL(&cpu_set,&locality_state_base->cpu_set_list_base[domain_idx])){
+              break;
+            }
+          }
+          if(domain_idx==domain_count){
+            locality_state_base->cpu_set_list_base[domain_idx]=cpu_set;
+            locality_state_base->cpu_count_list_base[domain_idx]=(u32)(CPU_COUNT(&cpu_set));
+            locality_state_base->flight_count_list_base[domain_idx]=0;
+            domain_count++;
+          }
+        }
+        locality_state_base->domain_idx_max=domain_count?(domain_count-1):0;
+        locality_state_base->domain_status=(domain_count>=2);
+      }else{
+        spawn_multi_locality_free(spawn_base);
+      }
+    }
+    return status;
+  }
+
+  void
+  spawn_multi_locality_place(spawn_simulthread_t *simulthread_base,u64 locality_key){
+/*
+Decide where a thread with a given locality key should run. Do not call from outside Spawn.
+
+In:
+
+  *simulthread_base is the idle simulthread about to be launched, whose spawn_t has locality keys enabled with at least 2 cache domains.
+
+  locality_key is as given to spawn_multi_one_keyed().
+
+Out:
+
+  simulthread_base->locality_status is 1 if the thread is to be pinned to the cache domain simulthread_base->locality_domain_idx, else 0 to let the OS place it.
+*/
+    u32 domain_idx;
+    u32 domain_idx_max;
+    u32 domain_other_idx;
+    spawn_locality_state_t *locality_state_base;
+    u8 locality_status;
+
+    locality_state_base=((spawn_t *)(simulthread_base->spawn_base))->locality_state_base;
+    domain_idx_max=locality_state_base->domain_idx_max;
+/*
+Hash the key, so that consecutive keys spread across domains.
+*/
+    domain_idx=(u32)((((locality_key*0x9E3779B97F4A7C15ULL)>>U32_BITS)*(domain_idx_max+1ULL))>>U32_BITS);
+    locality_status=1;
+    if(locality_state_base->cpu_count_list_base[domain_idx]<=__atomic_load_n(&locality_state_base->flight_count_list_base[domain_idx],__ATOMIC_RELAXED)){
+/*
+The home domain is saturated. If some other domain has an idle CPU, then let the OS steal the thread onto it. Otherwise, queue it on its home domain, where its data is likely to be cached.
+*/
+      domain_other_idx=0;
+      do{
+        if(__atomic_load_n(&locality_state_base->flight_count_list_base[domain_other_idx],__ATOMIC_RELAXED)<locality_state_base->cpu_count_list_base[domain_other_idx]){
+          locality_status=0;
+          break;
+        }
+      }while((domain_other_idx++)!=domain_idx_max);
+    }
+    simulthread_base->locality_domain_idx=domain_idx;
+    simulthread_base->locality_status=locality_status;
+    if(locality_status){
+      __atomic_fetch_add(&locality_state_base->flight_count_list_base[domain_idx],1,__ATOMIC_RELAXED);
+    }
+    return;
+  }
+
+  void
+  spawn_multi_stack_free(spawn_t *spawn_base){
+/*
+Unmap all pooled stacks, if any. Must not be called while any threads are in flight.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  No simulthread has a pooled stack.
+*/
+    spawn_simulthread_t *simulthread_base;
+    u32 simulthread_idx;
+
+    simulthread_idx=0;
+    do{
+      simulthread_base=&spawn_base->simulthread_list_base[simulthread_idx];
+      if(simulthread_base->stack_base){
+        munmap(simulthread_base->stack_base,(size_t)(spawn_base->stack_guard_size+spawn_base->stack_size));
+        simulthread_base->stack_base=NULL;
+      }
+    }while((simulthread_idx++)!=spawn_base->simulthread_idx_max);
+    return;
+  }
+
+  u8
+  spawn_multi_stack_set(spawn_t *spawn_base,ULONG stack_size,ULONG guard_size,u8 pool_status){
+/*
+Set the stack size and guard size of subsequently launched threads, and optionally give each simulthread a pooled stack to be reused by every thread launched on it, instead of the OS default stack (often 8 MiB of virtual memory each) being mapped and faulted in for each thread. Must not be called while any threads are in flight.
+
+In:
+
+  stack_size is the size of each stack, which is rounded up to a page multiple and to at least PTHREAD_STACK_MIN, or 0 to restore the OS default stack and guard sizes, in which case guard_size and pool_status are ignored.
+
+  guard_size is the size of the inaccessible region below each stack, which is rounded up to a page multiple, or 0 for none. It catches stack overflows, which small stacks make more likely.
+
+  pool_status is 1 to map (simulthread_idx_max+1) stacks now, and fault them in, so that launching a thread involves no memory mapping or page faults for its stack, else 0 to let the OS allocate stacks of the given size per thread.
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  Returns 1 if the pooled stacks couldn't be mapped, in which case the OS default stacks are restored, else 0.
+*/
+    u64 offset;
+    long page_size;
+    spawn_simulthread_t *simulthread_base;
+    u32 simulthread_idx;
+    u8 *stack_base;
+    u8 status;
+
+    spawn_multi_stack_free(spawn_base);
+    page_size=sysconf(_SC_PAGESIZE);
+    page_size=MAX(page_size,1);
+    if(stack_size){
+      stack_size=MAX(stack_size,(ULONG)(PTHREAD_STACK_MIN));
+      stack_size=(ULONG)((((u64)(stack_size)+(u64)(page_size)-1)/(u64)(page_size))*(u64)(page_size));
+      guard_size=(ULONG)((((u64)(guard_size)+(u64)(page_size)-1)/(u64)(page_size))*(u64)(page_size));
+    }else{
+      guard_size=0;
+      pool_status=0;
+    }
+    spawn_base->stack_guard_size=guard_size;
+    spawn_base->stack_size=stack_size;
+    status=0;
+    if(pool_status){
+      simulthread_idx=0;
+      do{
+        stack_base=(u8 *)(mmap(NULL,(size_t)(guard_size+stack_size),PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_STACK,-1,0));
+        status=(stack_base==MAP_FAILED);
+        if(status){
+          break;
+        }
+        simulthread_base=&spawn_base->simulthread_list_base[simulthread_idx];
+        simulthread_base->stack_base=stack_base;
+        if(guard_size){
+          mprotect(stack_base,(size_t)(guard_size),PROT_NONE);
+        }
+/*
+Fault in the stack now, from the top down, as it would be used.
+*/
+        offset=(u64)(guard_size)+stack_size;
+        do{
+          offset-=(u64)(page_size);
+          stack_base[offset]=0;
+        }while(offset!=guard_size);
+      }while((simulthread_idx++)!=spawn_base->simulthread_idx_max);
+      if(status){
+        spawn_multi_stack_free(spawn_base);
+        spawn_base->stack_guard_size=0;
+        spawn_base->stack_size=0;
+      }
+    }
+    return status;
+  }
+
+  int
+  spawn_multi_pthread_create(spawn_simulthread_t *simulthread_base,u64 locality_key,u8 locality_key_status){
+/*
+Launch a pthread on an idle simulthread. Do not call from outside Spawn.
+
+In:
+
+  *simulthread_base is an idle simulthread whose context.thread_idx has been set.
+
+  locality_key is as given to spawn_multi_one_keyed(), if locality_key_status is 1.
+
+  locality_key_status is 1 if locality_key is valid, else 0.
+
+Out:
+
+  Returns the return value of pthread_create().
+*/
+    pthread_attr_t pthread_attr;
+    u8 pthread_attr_status;
+    int pthread_status;
+    spawn_locality_state_t *locality_state_base;
+    spawn_t *spawn_base;
+
+    spawn_base=(spawn_t *)(simulthread_base->spawn_base);
+    if(spawn_base->speculate_state_base){
+      simulthread_base->launch_nanoseconds=spawn_nanosecond_get();
+      simulthread_base->done_status=0;
+    }
+    if(spawn_base->share_base){
+      spawn_multi_share_acquire(spawn_base);
+    }
+    locality_state_base=spawn_base->locality_state_base;
+    simulthread_base->locality_status=0;
+    if(locality_key_status&&locality_state_base&&locality_state_base->domain_status){
+      spawn_multi_locality_place(simulthread_base,locality_key);
+    }
+    pthread_attr_status=0;
+    if(simulthread_base->locality_status||spawn_base->stack_size){
+      if(!pthread_attr_init(&pthread_attr)){
+        pthread_attr_status=1;
+        if(simulthread_base->locality_status){
+          pthread_attr_setaffinity_np(&pthread_attr,sizeof(cpu_set_t),&locality_state_base->cpu_set_list_base[simulthread_base->locality_domain_idx]);
+        }
+/*
+A pooled stack is safe to reuse because the previous thread on this simulthread has been joined.
+*/
+        if(simulthread_base->stack_base){
+          pthread_attr_setstack(&pthread_attr,&simulthread_base->stack_base[spawn_base->stack_guard_size],(size_t)(spawn_base->stack_size));
+        }else if(spawn_base->stack_size){
+          pthread_attr_setstacksize(&pthread_attr,(size_t)(spawn_base->stack_size));
+          pthread_attr_setguardsize(&pthread_attr,(size_t)(spawn_base->stack_guard_size));
+        }
+      }
+    }
+    pthread_status=pthread_create(&simulthread_base->pthread,pthread_attr_status?&pthread_attr:NULL,spawn_simulthread_execute,&simulthread_base->context);
+    if(pthread_attr_status){
+      pthread_attr_destroy(&pthread_attr);
+    }
+    if(pthread_status&&simulthread_base->locality_status){
+      __atomic_fetch_sub(&locality_state_base->flight_count_list_base[simulthread_base->locality_domain_idx],1,__ATOMIC_RELAXED);
+      simulthread_base->locality_status=0;
+    }
+    if(pthread_status&&spawn_base->share_base){
+      spawn_multi_share_release(spawn_base);
+    }
+    return pthread_status;
+  }
+
+  u8
+  spawn_multi_speculate_reap(spawn_t *spawn_base,u32 *simulthread_idle_idx_base){
+/*
+Retire every simulthread which has finished, in whatever order. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init(), with speculative reexecution enabled and its mutex held by the caller.
+
+  *simulthread_idle_idx_base is writable.
+
+Out:
+
+  Returns 1 if at least one simulthread is idle, else 0.
+
+  *simulthread_idle_idx_base is the index of an idle simulthread if the return value is 1, else undefined.
+*/
+    spawn_simulthread_t *simulthread_base;
+    u8 simulthread_idle_status;
+    u32 simulthread_idx;
+    u32 simulthread_idx_max;
+    spawn_simulthread_t *simulthread_list_base;
+    spawn_speculate_state_t *speculate_state_base;
+
+    speculate_state_base=spawn_base->speculate_state_base;
+    simulthread_list_base=spawn_base->simulthread_list_base;
+    simulthread_idx_max=spawn_base->simulthread_idx_max;
+    simulthread_idle_status=0;
+    simulthread_idx=0;
+    do{
+      simulthread_base=&simulthread_list_base[simulthread_idx];
+      if(simulthread_base->active_status&&simulthread_base->done_status){
+        spawn_multi_pthread_join(simulthread_base);
+        simulthread_base->active_status=0;
+        speculate_state_base->simulthread_active_count--;
+      }
+      if(!simulthread_base->active_status){
+        *simulthread_idle_idx_base=simulthread_idx;
+        simulthread_idle_status=1;
+      }
+    }while((simulthread_idx++)!=simulthread_idx_max);
+    return simulthread_idle_status;
+  }
+
+  u8
+  spawn_multi_speculate_one(spawn_t *spawn_base,ULONG unique_idx,u64 locality_key,u8 locality_key_status){
+/*
+Equivalent to spawn_multi_launch() when speculative reexecution is enabled. Simulthreads are retired in whatever order they finish, rather than in launch order, so a straggler doesn't block the launch of subsequent threads. Do not call from outside Spawn.
+
+In:
+
+  locality_key and locality_key_status are as defined in spawn_multi_launch():In.
+
+  unique_idx is as defined in spawn_multi_one():In.
+
+  *spawn_base is as returned by spawn_multi_init(), with speculative reexecution enabled.
+
+Out:
+
+  Returns as defined in spawn_multi_one():Out.
+*/
+    int pthread_status;
+    spawn_simulthread_t *simulthread_base;
+    u32 simulthread_idle_idx;
+    spawn_speculate_state_t *speculate_state_base;
+    u8 status;
+
+    speculate_state_base=spawn_base->speculate_state_base;
+    simulthread_idle_idx=0;
+    status=0;
+    pthread_mutex_lock(&speculate_state_base->mutex);
+    do{
+      if(spawn_multi_speculate_reap(spawn_base,&simulthread_idle_idx)&&(speculate_state_base->simulthread_active_count<=__atomic_load_n(&spawn_base->simulthread_limit_idx_max,__ATOMIC_RELAXED))){
+        if(spawn_deadline_passed_get(spawn_base)){
+          break;
+        }
+        simulthread_base=&spawn_base->simulthread_list_base[simulthread_idle_idx];
+        simulthread_base->context.thread_idx=unique_idx;
+        pthread_status=spawn_multi_pthread_create(simulthread_base,locality_key,locality_key_status);
+        if(!pthread_status){
+          simulthread_base->active_status=1;
+          speculate_state_base->simulthread_active_count++;
+          break;
+        }
+/*
+As in spawn_multi_one(), if the OS is too busy to launch another thread, then wait for an active one to finish, unless there aren't any.
+*/
+        if(!(((pthread_status==EAGAIN)||(pthread_status==ENOMEM))&&speculate_state_base->simulthread_active_count)){
+          status=1;
+          break;
+        }
+      }
+      pthread_cond_wait(&speculate_state_base->cond,&speculate_state_base->mutex);
+    }while(1);
+    spawn_base->simulthread_active_status=!!speculate_state_base->simulthread_active_count;
+    pthread_mutex_unlock(&speculate_state_base->mutex);
+    return status;
+  }
+
+  void
+  spawn_multi_speculate_retire_all(spawn_t *spawn_base){
+/*
+Equivalent to spawn_multi_retire_all() when speculative reexecution is enabled. Use each simulthread which becomes idle to launch a duplicate of the longest-running straggler. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init(), with speculative reexecution enabled.
+
+Out:
+
+  All pending threads, including duplicates, have finished.
+*/
+    u64 launch_nanoseconds;
+    u64 launch_nanoseconds_min;
+    u64 nanoseconds;
+    spawn_simulthread_t *simulthread_base;
+    u32 simulthread_idle_idx;
+    u8 simulthread_idle_status;
+    u32 simulthread_idx;
+    u32 simulthread_idx_max;
+    spawn_simulthread_t *simulthread_list_base;
+    u32 simulthread_straggler_idx;
+    spawn_speculate_state_t *speculate_state_base;
+    u8 *state_list_base;
+    u64 straggler_nanoseconds;
+    struct timespec timespec;
+    u64 wake_nanoseconds;
+
+    speculate_state_base=spawn_base->speculate_state_base;
+    simulthread_list_base=spawn_base->simulthread_list_base;
+    simulthread_idx_max=spawn_base->simulthread_idx_max;
+    state_list_base=speculate_state_base->state_list_base;
+    straggler_nanoseconds=speculate_state_base->straggler_nanoseconds;
+    simulthread_idle_idx=0;
+    pthread_mutex_lock(&speculate_state_base->mutex);
+    do{
+      simulthread_idle_status=spawn_multi_speculate_reap(spawn_base,&simulthread_idle_idx);
+      wake_nanoseconds=0;
+      while(speculate_state_base->simulthread_active_count&&simulthread_idle_status&&(!__atomic_load_n(&spawn_base->stop_status,__ATOMIC_RELAXED))&&(speculate_state_base->simulthread_active_count<=__atomic_load_n(&spawn_base->simulthread_limit_idx_max,__ATOMIC_RELAXED))){
+/*
+Find the longest-running thread which has neither finished nor been duplicated.
+*/
+        launch_nanoseconds_min=U64_MAX;
+        simulthread_straggler_idx=0;
+        simulthread_idx=0;
+        do{
+          simulthread_base=&simulthread_list_base[simulthread_idx];
+          if(simulthread_base->active_status&&!simulthread_base->done_status&&(simulthread_base->context.thread_idx<=speculate_state_base->thread_idx_max)&&!__atomic_load_n(&state_list_base[simulthread_base->context.thread_idx],__ATOMIC_ACQUIRE)){
+            launch_nanoseconds=simulthread_base->launch_nanoseconds;
+            if(launch_nanoseconds<launch_nanoseconds_min){
+              launch_nanoseconds_min=launch_nanoseconds;
+              simulthread_straggler_idx=simulthread_idx;
+            }
+          }
+        }while((simulthread_idx++)!=simulthread_idx_max);
+        if(launch_nanoseconds_min==U64_MAX){
+          break;
+        }
+        nanoseconds=spawn_nanosecond_get();
+        if((nanoseconds-launch_nanoseconds_min)<straggler_nanoseconds){
+/*
+It's too soon to duplicate anything. Wake up when the oldest thread becomes a straggler, if nothing else finishes first.
+*/
+          wake_nanoseconds=launch_nanoseconds_min+straggler_nanoseconds;
+          break;
+        }
+        simulthread_base=&simulthread_list_base[simulthread_straggler_idx];
+        if(__atomic_fetch_or(&state_list_base[simulthread_base->context.thread_idx],SPAWN_SPECULATE_DUPLICATED,__ATOMIC_ACQ_REL)&SPAWN_SPECULATE_COMMITTED){
+/*
+It finished just now, but hasn't marked itself done yet.
+*/
+          continue;
+        }
+        simulthread_list_base[simulthread_idle_idx].context.thread_idx=simulthread_base->context.thread_idx;
+        simulthread_base=&simulthread_list_base[simulthread_idle_idx];
+/*
+Don't pin the duplicate, because its home domain is presumably where the straggler is stuck.
+*/
+        if(spawn_multi_pthread_create(simulthread_base,0,0)){
+/*
+The OS won't give us another thread right now. That's no problem because the original attempt is still running.
+*/
+          break;
+        }
+        simulthread_base->active_status=1;
+        speculate_state_base->simulthread_active_count++;
+        simulthread_idle_status=spawn_multi_speculate_reap(spawn_base,&simulthread_idle_idx);
+      }
+      if(speculate_state_base->simulthread_active_count){
+        if(wake_nanoseconds){
+          timespec.tv_sec=(time_t)(wake_nanoseconds/1000000000ULL);
+          timespec.tv_nsec=(long)(wake_nanoseconds%1000000000ULL);
+          pthread_cond_timedwait(&speculate_state_base->cond,&speculate_state_base->mutex,&timespec);
+        }else{
+          pthread_cond_wait(&speculate_state_base->cond,&speculate_state_base->mutex);
+        }
+      }
+    }while(speculate_state_base->simulthread_active_count);
+    pthread_mutex_unlock(&speculate_state_base->mutex);
+    return;
+  }
+
+  u8
+  spawn_multi_launch(spawn_t *spawn_base,ULONG unique_idx,u64 locality_key,u8 locality_key_status){
+/*
+Spawn a thread asynchronously, optionally with a locality key. Do not call from outside Spawn.
+
+In:
+
+  locality_key is as defined in spawn_multi_one_keyed():In, if locality_key_status is 1.
+
+  locality_key_status is 1 if locality_key is valid, else 0.
+
+  unique_idx is as defined in spawn_multi_one():In.
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  Returns as defined in spawn_multi_one():Out.
+*/
+    int pthread_status;
+    u8 simulthread_active_status;
+    spawn_simulthread_t *simulthread_base;
+    u64 simulthread_active_count;
+    u32 simulthread_idx_max;
+    u32 simulthread_launch_idx;
+    u8 simulthread_launched_status;
+    u32 simulthread_limit_idx_max;
+    spawn_simulthread_t *simulthread_list_base;
+    u32 simulthread_retire_idx;
+    u8 status;
+
+    if(__atomic_load_n(&spawn_base->stop_status,__ATOMIC_RELAXED)){
+/*
+The submission was cancelled by spawn_stop_set().
+*/
+      return 0;
+    }
+    if(spawn_base->speculate_state_base){
+      status=spawn_multi_speculate_one(spawn_base,unique_idx,locality_key,locality_key_status);
+      return status;
+    }
+    simulthread_list_base=spawn_base->simulthread_list_base;
+    simulthread_idx_max=spawn_base->simulthread_idx_max;
+    simulthread_launch_idx=spawn_base->simulthread_launch_idx;
+    simulthread_retire_idx=spawn_base->simulthread_retire_idx;
+    simulthread_active_status=spawn_base->simulthread_active_status;
+/*
+Count the active simulthreads, which are those from the retire index up to, but not including, the launch index, modulo (simulthread_idx_max+1). They're all active if the indexes are equal and simulthread_active_status is 1.
+*/
+    simulthread_active_count=0;
+    if(simulthread_active_status){
+      simulthread_active_count=simulthread_launch_idx;
+      if(simulthread_launch_idx<=simulthread_retire_idx){
+        simulthread_active_count+=(u64)(simulthread_idx_max)+1;
+      }
+      simulthread_active_count-=simulthread_retire_idx;
+    }
+/*
+The limit can be changed by another thread at any time, so read it once.
+*/
+    simulthread_limit_idx_max=__atomic_load_n(&spawn_base->simulthread_limit_idx_max,__ATOMIC_RELAXED);
+    while(simulthread_active_count>simulthread_limit_idx_max){
+/*
+We're maxed out on simulthreads, or the limit was just lowered. Retire the oldest until we can launch one.
+*/
+      simulthread_base=&simulthread_list_base[simulthread_retire_idx];
+      spawn_multi_pthread_join(simulthread_base);
+      simulthread_retire_idx++;
+      if(simulthread_retire_idx>simulthread_idx_max){
+        simulthread_retire_idx=0;
+      }
+      simulthread_active_count--;
+    }
+    simulthread_active_status=!!simulthread_active_count;
+    if(spawn_deadline_passed_get(spawn_base)){
+/*
+Retiring took so long that the deadline of spawn_multi_deadline() passed meanwhile, so don't launch.
+*/
+      spawn_base->simulthread_retire_idx=simulthread_retire_idx;
+      spawn_base->simulthread_active_status=simulthread_active_status;
+      return 0;
+    }
+/*
+Launch the new simulthread with thread_idx==unique_idx.
+*/
+    simulthread_base=&simulthread_list_base[simulthread_launch_idx];
+    simulthread_base->context.thread_idx=unique_idx;
+    do{
+      pthread_status=spawn_multi_pthread_create(simulthread_base,locality_key,locality_key_status);
+      if(pthread_status){
+        status=1;
+        simulthread_launched_status=0;
+        if((pthread_status==EAGAIN)||((pthread_status==ENOMEM)&&simulthread_active_status)){
+/*
+We may or may not have active simulthreads, but the OS is too busy to launch another thread. (If we have ENOMEM but no active simulthreads, that's a fatal error because there's no indication that the OS will ever be able to launch another thread. In that case, we can't arrive here.) If any simulthreads are active, then retire one of them, so we can hopefully launch another one.
+*/
+          status=0;
+          if(simulthread_active_status){
+            spawn_multi_pthread_join(&simulthread_list_base[simulthread_retire_idx]);
+            simulthread_retire_idx++;
+            if(simulthread_retire_idx>simulthread_idx_max){
+              simulthread_retire_idx=0;
+            }
+            simulthread_active_status=(simulthread_launch_idx!=simulthread_retire_idx);
+          }
+        }
+      }else{
+        status=0;
+        simulthread_launched_status=1;
+        simulthread_active_status=simulthread_launched_status;
+        simulthread_launch_idx++;
+        if(simulthread_launch_idx>simulthread_idx_max){
+          simulthread_launch_idx=0;
+        }
+      }
+    }while(!(status|simulthread_launched_status));
+    spawn_base->simulthread_launch_idx=simulthread_launch_idx;
+    spawn_base->simulthread_retire_idx=simulthread_retire_idx;
+    spawn_base->simulthread_active_status=simulthread_active_status;
+    return status;
+  }
+
+  u8
+  spawn_multi_one(spawn_t *spawn_base,ULONG unique_idx){
+/*
+Spawn a thread asynchronously.
+
+In:
+
+  unique_idx is a thread index used once until spawn_multi_retire_all() is called, after which it may be reused. It's used to address the reason for which this function is called instead of spawn_multi(), namely, that the thread indexes of interest aren't known ahead of time. For example, a master thread could browse a list, looking for work to do. Then some of the items in the list would invoke slave threads, whereas others would not. In this example, a linearly increasing thread index would be of little use to the target function. unique_idx gets around this problem by permitting thread indexes to be sparse, and even out-of-order.
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  Returns 1 on failure, else 0. Success means that the thread was launched (but might not have retired), unless spawn_stop_set() has cancelled the submission, in which case nothing is launched. Failure will only be returned in the case of a fatal error, as opposed to a temporary failure caused by the OS being overloaded with threads.
+
+  Regardless of the return value, the caller must not call any other Spawn function, except this one, until spawn_multi_retire_all() has been called -- unless the call involves purely orthogonal writable data structures, including a separate *spawn_base.
+*/
+    u8 status;
+
+    status=spawn_multi_launch(spawn_base,unique_idx,0,0);
+    return status;
+  }
+
+  u8
+  spawn_multi_one_keyed(spawn_t *spawn_base,ULONG unique_idx,u64 locality_key){
+/*
+Equivalent to spawn_multi_one(), except that threads with equal locality keys tend to run on CPUs which share a cache, once spawn_multi_locality_enable() has been called. Use the key to identify the data that the thread will mostly touch, such as a shard or partition number. If the home cache domain of the key is saturated while another domain has an idle CPU, then the thread is left for the OS to place, so that throughput isn't sacrificed for locality.
+
+In:
+
+  locality_key is any value, with equal values indicating threads which would benefit from sharing a cache.
+
+  unique_idx is as defined in spawn_multi_one():In.
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  Returns as defined in spawn_multi_one():Out.
+*/
+    u8 status;
+
+    status=spawn_multi_launch(spawn_base,unique_idx,locality_key,1);
+    return status;
+  }
+
+  u8
+  spawn_multi_bulk(spawn_t *spawn_base,ULONG *idx_list_base,ULONG *bitmap_base,ULONG item_idx_max){
+/*
+Launch a bulk submission as a few chunks per simulthread, so the master pays for one launch per chunk instead of one per thread_idx. Do not call from outside Spawn.
+
+In:
+
+  idx_list_base is as defined in spawn_multi_list():In, or NULL.
+
+  bitmap_base is as defined in spawn_multi_bitmap():In, or NULL if idx_list_base is not. If both are NULL, then the thread indexes are 0 through item_idx_max.
+
+  item_idx_max is the maximum index into whichever of the above isn't NULL, else the maximum thread_idx.
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  Returns as defined in spawn_multi():Out.
+*/
+    u64 chunk_count;
+    ULONG chunk_idx;
+    ULONG chunk_idx_max;
+    ULONG chunk_item_count;
+    ULONG item_idx;
+    u8 status;
+
+    if(spawn_base->speculate_state_base){
+/*
+Speculative reexecution works per thread_idx, so launch them one at a time.
+*/
+      status=0;
+      item_idx=0;
+      do{
+        if(idx_list_base){
+          status=spawn_multi_one(spawn_base,idx_list_base[item_idx]);
+        }else if((!bitmap_base)||BIT_GET(bitmap_base,item_idx)){
+          status=spawn_multi_one(spawn_base,item_idx);
+        }
+      }while((!status)&&(!__atomic_load_n(&spawn_base->stop_status,__ATOMIC_RELAXED))&&((item_idx++)!=item_idx_max));
+      return status;
+    }
+    chunk_count=((u64)(spawn_base->simulthread_idx_max)+1)<<SPAWN_BULK_CHUNK_COUNT_LOG2;
+    chunk_item_count=(ULONG)(((u64)(item_idx_max)/chunk_count)+1);
+    if(bitmap_base){
+/*
+Chunks must be whole words, so that no 2 simulthreads scan the same one.
+*/
+      chunk_item_count=(ULONG)(MIN((((u64)(chunk_item_count)+ULONG_BIT_MAX)>>ULONG_BITS_LOG2)<<ULONG_BITS_LOG2,(u64)(item_idx_max)+1));
+    }
+    spawn_base->bulk_bitmap_base=bitmap_base;
+    spawn_base->bulk_idx_list_base=idx_list_base;
+    spawn_base->bulk_chunk_item_count=chunk_item_count;
+    spawn_base->bulk_item_idx_max=item_idx_max;
+    chunk_idx_max=item_idx_max/chunk_item_count;
+    chunk_idx=0;
+    do{
+      status=spawn_multi_one(spawn_base,chunk_idx);
+    }while((!status)&&(!__atomic_load_n(&spawn_base->stop_status,__ATOMIC_RELAXED))&&((chunk_idx++)!=chunk_idx_max));
+    return status;
+  }
+
+  u8
+  spawn_multi_list(spawn_t *spawn_base,ULONG *idx_list_base,ULONG idx_idx_max,u8 sort_status){
+/*
+Spawn one thread per entry in a list of thread indexes, much faster than calling spawn_multi_one() for each of them, because the master only launches a few chunks of the list per simulthread, each of which runs its entries back to back. Each entry still gets its own context.thread_idx and instrumentation, exactly as if launched by spawn_multi_one().
+
+In:
+
+  idx_list_base is the base of (idx_idx_max+1) thread indexes, which must be unique until spawn_multi_retire_all() is called. It must not be modified until then.
+
+  idx_idx_max is the maximum index into idx_list_base.
+
+  sort_status is 1 to sort the list into ascending order in place before launching, so that neighboring thread indexes run back to back on the same simulthread, which improves cache locality if they touch neighboring data, else 0.
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  Returns as defined in spawn_multi():Out.
+
+  Regardless of the return value, the caller must not call any other Spawn function until spawn_multi_retire_all() has been called, as with spawn_multi().
+*/
+    u8 status;
+
+    spawn_stat_plan(spawn_base,NULL,idx_idx_max);
+    if(sort_status){
+      qsort(idx_list_base,(size_t)(idx_idx_max)+1,sizeof(ULONG),spawn_bulk_compare);
+    }
+    status=spawn_multi_bulk(spawn_base,idx_list_base,NULL,idx_idx_max);
+    return status;
+  }
+
+  u8
+  spawn_multi_bitmap(spawn_t *spawn_base,ULONG *bitmap_base,ULONG bit_idx_max){
+/*
+Equivalent to spawn_multi_list(), except that the thread indexes are given as the set bits of a bitmap, which is implicitly sorted. The bitmap is scanned in parallel by the simulthreads, rather than by the master.
+
+In:
+
+  bitmap_base is the base of a bitmap, as manipulated by BIT_SET(), with bit N set if thread_idx N is to be launched. It must not be modified until spawn_multi_retire_all() is called.
+
+  bit_idx_max is the maximum bit index, which may be less than the bitmap size in bits.
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  Returns as defined in spawn_multi_list():Out.
+*/
+    u8 status;
+
+    spawn_stat_plan(spawn_base,bitmap_base,bit_idx_max);
+    status=spawn_multi_bulk(spawn_base,NULL,bitmap_base,bit_idx_max);
+    return status;
+  }
+
+  u8
+  spawn_multi(spawn_t *spawn_base,ULONG thread_idx_max){
+/*
+Keep the OS thread engine as busy as possible with pending threads, within the specified simultaneous thread limit. Make sure your threads are long enough that the typical launch latency (perhpas 1 ms) isn't significant.
+
+In:
+
+  This function must not be recursed or nested within spawn_multi_one(). Otherwise it's possible that OS thread handles will be exhausted.
+
+  thread_idx_max is the maximum thread number.
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  Returns 1 if not all threads were launched successfully, else 0. Failure will only be returned in the case of a fatal error, as opposed to a temporary failure caused by the OS being overloaded with threads.
+
+  Regardless of the return value, the caller must not call any other Spawn function, including this one, until spawn_multi_retire_all() has been called -- unless the call involves purely orthogonal writable data structures, including a separate *spawn_base.
+*/
+    ULONG i;
+    u8 status;
+
+    spawn_stat_plan(spawn_base,NULL,thread_idx_max);
+    if(spawn_base->prefetch_function_base&&!spawn_base->sink_state_base){
+/*
+The prefetch function needs to know which thread indexes are coming next on each simulthread, so launch contiguous ranges of them, as spawn_multi_list() would.
+*/
+      status=spawn_multi_bulk(spawn_base,NULL,NULL,thread_idx_max);
+      return status;
+    }
+    i=0;
+    do{
+      status=spawn_multi_one(spawn_base,i);
+    }while((!status)&&(!__atomic_load_n(&spawn_base->stop_status,__ATOMIC_RELAXED))&&((i++)!=thread_idx_max));
+    return status;
+  }
+
+  void
+  spawn_multi_retire_all(spawn_t *spawn_base){
+/*
+Retire all pending threads.
+
+In:
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  All pending threads, if any, have finished. If speculative reexecution is enabled, then duplicates of stragglers have been launched on idle simulthreads in the meantime, and the results of the first attempt at each thread_idx to finish have been committed. The caller must, in general, call spawn_multi_rewind(), but can sometimes avoid that step (see its documentation). If all work is done, then the caller can directly call spawn_multi_free() without calling spawn_multi_rewind().
+*/
+    u8 simulthread_active_status;
+    spawn_simulthread_t *simulthread_base;
+    u32 simulthread_idx_max;  
+    u32 simulthread_launch_idx;
+    spawn_simulthread_t *simulthread_list_base;
+    u32 simulthread_retire_idx;
+    spawn_speculate_state_t *speculate_state_base;
+
+    simulthread_active_status=spawn_base->simulthread_active_status;
+    speculate_state_base=spawn_base->speculate_state_base;
+    if(simulthread_active_status&&speculate_state_base){
+      spawn_multi_speculate_retire_all(spawn_base);
+    }else if(simulthread_active_status){
+      simulthread_list_base=spawn_base->simulthread_list_base;
+      simulthread_idx_max=spawn_base->simulthread_idx_max;
+      simulthread_launch_idx=spawn_base->simulthread_launch_idx;
+      simulthread_retire_idx=spawn_base->simulthread_retire_idx;
+      do{
+        simulthread_base=&simulthread_list_base[simulthread_retire_idx];
+        spawn_multi_pthread_join(simulthread_base);
+        simulthread_retire_idx++;
+        if(simulthread_retire_idx>simulthread_idx_max){
+          simulthread_retire_idx=0;
+        }
+      }while(simulthread_retire_idx!=simulthread_launch_idx);
+    }
+    if(speculate_state_base){
+      memset(speculate_state_base->state_list_base,0,(size_t)(speculate_state_base->thread_idx_max)+1);
+    }
+    spawn_base->bulk_bitmap_base=NULL;
+    spawn_base->bulk_idx_list_base=NULL;
+    spawn_base->bulk_chunk_item_count=0;
+    spawn_base->bulk_item_idx_max=0;
+    spawn_base->simulthread_launch_idx=0;
+    spawn_base->simulthread_retire_idx=0;
+    spawn_base->simulthread_active_status=0;
+    return;
+  }
+
+  u8
+  spawn_multi_deadline(spawn_t *spawn_base,ULONG thread_idx_max,u64 deadline_nanoseconds,u8 wrap_status,ULONG *done_bitmap_base){
+/*
+Equivalent to spawn_multi() followed by spawn_multi_retire_all(), except that no thread is launched after a deadline. This is useful when a good answer on time is worth more than the best answer late.
+
+In:
+
+  deadline_nanoseconds is the time budget, starting now.
+
+  done_bitmap_base is the base of a bitmap with (thread_idx_max+1) bits, which need not be initialized. Use BIT_GET() to read it.
+
+  thread_idx_max is as defined in spawn_multi():In.
+
+  *spawn_base is as returned by spawn_multi_init().
+
+  wrap_status is 1 to make spawn_stop_get() return 1 to running threads once the deadline has passed, else 0 to let them run to completion.
+
+Out:
+
+  Returns as defined in spawn_multi():Out.
+
+  *done_bitmap_base has bit N set if and only if thread_idx N ran to completion (which includes returning early because spawn_stop_get() returned 1). All threads have retired. A stop caused by the deadline is cleared, but one requested by spawn_stop_set() remains in effect. The caller must, in general, call spawn_multi_rewind(), as after spawn_multi_retire_all().
+*/
+    ULONG i;
+    u8 status;
+
+    spawn_stat_plan(spawn_base,NULL,thread_idx_max);
+    memset(done_bitmap_base,0,(size_t)(((thread_idx_max>>ULONG_BITS_LOG2)+1)<<ULONG_SIZE_LOG2));
+    spawn_deadline_set(spawn_base,deadline_nanoseconds);
+    spawn_base->deadline_wrap_status=wrap_status;
+    spawn_base->done_bitmap_base=done_bitmap_base;
+    status=0;
+    i=0;
+    do{
+      if(spawn_deadline_passed_get(spawn_base)){
+        break;
+      }
+      status=spawn_multi_one(spawn_base,i);
+    }while((!status)&&(!__atomic_load_n(&spawn_base->stop_status,__ATOMIC_RELAXED))&&((i++)!=thread_idx_max));
+    spawn_multi_retire_all(spawn_base);
+    spawn_base->deadline_nanoseconds=0;
+    spawn_base->deadline_wrap_status=0;
+    spawn_base->done_bitmap_base=NULL;
+    spawn_base->stop_status&=(u8)(~SPAWN_STOP_DEADLINE);
+    return status;
+  }
+
+  void
+  spawn_multi_free(spawn_t *spawn_base){
+    if(spawn_base){
+      spawn_multi_budget_free(spawn_base);
+      spawn_multi_share_leave(spawn_base);
+      spawn_multi_locality_free(spawn_base);
+      spawn_memo_free(spawn_base);
+      spawn_perf_free(spawn_base);
+      spawn_sink_close(spawn_base);
+      spawn_speculate_free(spawn_base);
+      spawn_multi_stack_free(spawn_base);
+      spawn_stat_free(spawn_base);
+      spawn_io_free(spawn_base);
+      spawn_log_close(spawn_base);
+      spawn_free(spawn_base->simulthread_list_base);
+      spawn_free(spawn_base);
+    }
+    return;
+  }
+
+  void
+  spawn_multi_rewind(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base,spawn_t *spawn_base){
+/*
+Reset the Spawn engine without changing the memory map. It is not necessary to call this function unless a new function_base or readonly_string_base is to be used in a subsequent spawn_multi() or spawn_multi_one(), in which case, it must be called after spawn_multi_retire_all().
+
+In:
+
+  function_base is as defined in spawn_multi_init():In.
+
+  readonly_string_base is as defined in spawn_multi_init():In.
+
+  *spawn_base is as returned by spawn_multi_init().
+*/
+    u32 i;
+    u32 simulthread_idx_max;
+    spawn_simulthread_t *simulthread_list_base;
+
+    spawn_memo_rewind(spawn_base,function_base);
+    spawn_base->function_base=function_base;
+    spawn_base->simulthread_launch_idx=0;
+    spawn_base->simulthread_retire_idx=0;
+    spawn_base->simulthread_active_status=0;
+    spawn_base->stop_status=0;
+    simulthread_list_base=spawn_base->simulthread_list_base;
+    simulthread_idx_max=spawn_base->simulthread_idx_max;
+    i=0;
+    do{
+      simulthread_list_base[i].context.readonly_string_base=readonly_string_base;
+    }while((i++)!=simulthread_idx_max);
+    return;
+  }
+
+  void
+  spawn_multi_simulthread_limit_set(spawn_t *spawn_base,u32 simulthread_limit_idx_max){
+/*
+Change the maximum number of simulthreads in flight without reinitializing. Unlike other Spawn functions, this one may be called from any thread at any time, including while threads are in flight, so that concurrency can be backed off within milliseconds when other processes need the CPUs, then ramped back up. Lowering the limit doesn't interrupt threads already in flight; no more threads are launched until fewer than (simulthread_limit_idx_max+1) remain.
+
+In:
+
+  simulthread_limit_idx_max is 1 less than the new maximum number of simulthreads in flight. It's clipped to simulthread_idx_max as given to spawn_multi_init(), which is therefore the ceiling to which concurrency can be raised. spawn_simulthread_context_t.simulthread_idx continues to range up to simulthread_idx_max, so per-simulthread storage sized accordingly is preserved across changes of the limit.
+
+  *spawn_base is as returned by spawn_multi_init().
+
+Out:
+
+  The limit has been changed, effective at the next thread launch.
+*/
+    simulthread_limit_idx_max=MIN(simulthread_limit_idx_max,spawn_base->simulthread_idx_max);
+    __atomic_store_n(&spawn_base->simulthread_limit_idx_max,simulthread_limit_idx_max,__ATOMIC_RELAXED);
+    return;
+  }
+
+  spawn_t *
+  spawn_multi_init(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base,u32 simulthread_idx_max){
+/*
+Initialize the Spawn engine for multithreaded mode.
+
+In:
+
+  function_base is the base of a function which accepts a (spawn_simulthread_context_t *) and has no return value (because all communication occurs via memory). Typically, this is a bridge function which then invokes the "real" thread code.
+
+  readonly_string_base is NULL, or the base of a string to which all threads shall be given read access, via spawn_simulthread_context_t.readonly_string_base.
+
+  simulthread_idx_max is 1 less than the maximum allowable number of simultaneous threads ("simulthreads") in flight. All values are valid. Useful to limit resource consumption and kernel overhead due to excessive simulthreads. The simulthread index gets copied to the spawn_simulthread_context_t.simulthread_idx, which will never exceed spawn_simulthread_context_t.thread_idx. (In monothreaded mode, simulthread_idx is always 0.) Both values can be read via the pointer passed to the function at function_base. The number of simulthreads actually allowed in flight can later be lowered, and raised again up to this value, with spawn_multi_simulthread_limit_set().
+
+Out:
+
+  Returns NULL on failure, else a (spawn_t *) for use with future calls to the Spawn engine.
+*/
+    u32 i;
+    spawn_simulthread_t *simulthread_list_base;
+    u64 simulthread_list_size;
+    spawn_t *spawn_base;
+
+    simulthread_list_size=simulthread_idx_max;
+    simulthread_list_size++;
+    simulthread_list_size*=sizeof(spawn_simulthread_t);
+    simulthread_list_base=NULL;
+    if(simulthread_list_size<=ULONG_MAX){
+      simulthread_list_base=(spawn_simulthread_t *)(spawn_malloc((ULONG)(simulthread_list_size-1)));
+    }
+    spawn_base=NULL;
+    if(simulthread_list_base){
+      spawn_base=(spawn_t *)(spawn_malloc(sizeof(spawn_t)-1));
+      if(spawn_base){
+        spawn_base->budget_state_base=NULL;
+        spawn_base->bulk_bitmap_base=NULL;
+        spawn_base->bulk_idx_list_base=NULL;
+        spawn_base->done_bitmap_base=NULL;
+        spawn_base->function_base=function_base;
+        spawn_base->io_ring_list_base=NULL;
+        spawn_base->locality_state_base=NULL;
+        spawn_base->log_state_base=NULL;
+        spawn_base->memo_state_base=NULL;
+        spawn_base->perf_state_base=NULL;
+        spawn_base->prefetch_function_base=NULL;
+        spawn_base->share_base=NULL;
+        spawn_base->simulthread_list_base=simulthread_list_base;
+        spawn_base->sink_state_base=NULL;
+        spawn_base->speculate_state_base=NULL;
+        spawn_base->stat_base=NULL;
+        spawn_base->deadline_nanoseconds=0;
+        spawn_base->bulk_chunk_item_count=0;
+        spawn_base->bulk_item_idx_max=0;
+        spawn_base->stack_guard_size=0;
+        spawn_base->stack_size=0;
+        spawn_base->stat_size=0;
+        spawn_base->prefetch_count=0;
+        spawn_base->share_job_idx=0;
+        spawn_base->simulthread_idx_max=simulthread_idx_max;
+        spawn_base->simulthread_launch_idx=0;
+        spawn_base->simulthread_limit_idx_max=simulthread_idx_max;
+        spawn_base->deadline_wrap_status=0;
+        spawn_base->stop_status=0;
+        spawn_base->simulthread_retire_idx=0;
+        spawn_base->simulthread_active_status=0;
+        i=0;
+        do{
+          simulthread_list_base[i].context.readonly_string_base=readonly_string_base;
+          simulthread_list_base[i].context.simulthread_idx=i;
+          simulthread_list_base[i].stack_base=NULL;
+          simulthread_list_base[i].spawn_base=spawn_base;
+          simulthread_list_base[i].perf_group_fd=-1;
+        }while((i++)!=simulthread_idx_max);
+      }else{
+        spawn_free(simulthread_list_base);
+      }
+    }
+    return spawn_base;
+  }
+
+  void
+  spawn_multi_backoff(u32 *backoff_count_base){
+/*
+Wait a little while for another thread to make progress, waiting longer each time in a row that this is called. Do not call from outside Spawn.
+
+In:
+
+  *backoff_count_base is 0 on the first call after progress was made, else as returned by the previous call.
+
+Out:
+
+  *backoff_count_base has been incremented, saturating.
+*/
+    u32 backoff_count;
+    struct timespec timespec;
+
+    backoff_count=*backoff_count_base;
+    if(backoff_count<SPAWN_BACKOFF_SPIN_COUNT){
+      __asm__ __volatile__("" ::: "memory");
+    }else if(backoff_count<(SPAWN_BACKOFF_SPIN_COUNT<<1)){
+      sched_yield();
+    }else{
+/*
+Sleep for 1, 2, 4... up to 1024 microseconds, so that an idle stage costs next to nothing, while a stage which just ran dry wakes up quickly.
+*/
+      timespec.tv_sec=0;
+      timespec.tv_nsec=1000L<<MIN(backoff_count-(SPAWN_BACKOFF_SPIN_COUNT<<1),10U);
+      nanosleep(&timespec,NULL);
+    }
+    if(backoff_count!=U32_MAX){
+      backoff_count++;
+    }
+    *backoff_count_base=backoff_count;
+    return;
+  }
+
+  u8
+  spawn_multi_pipe_queue_pop(spawn_pipe_stage_t *stage_base,u8 **item_base_base){
+/*
+Dequeue an item from the input queue of a pipeline stage, without blocking. The queue is a bounded lock-free multiproducer multiconsumer ring, in which each cell carries a sequence number that tells producers and consumers whose turn it is. Do not call from outside Spawn.
+
+In:
+
+  *stage_base is the stage whose input queue to pop.
+
+  *item_base_base is writable.
+
+Out:
+
+  Returns 1 if the queue was empty, else 0.
+
+  *item_base_base is the dequeued item if the return value is 0, else undefined.
+*/
+    spawn_pipe_cell_t *cell_base;
+    u64 cell_idx_max;
+    i64 delta;
+    u64 pop_idx;
+    u64 sequence;
+
+    cell_idx_max=stage_base->cell_idx_max;
+    pop_idx=__atomic_load_n(&stage_base->pop_idx,__ATOMIC_RELAXED);
+    do{
+      cell_base=&stage_base->cell_list_base[pop_idx&cell_idx_max];
+      sequence=__atomic_load_n(&cell_base->sequence,__ATOMIC_ACQUIRE);
+      delta=(i64)(sequence-(pop_idx+1));
+      if(!delta){
+        if(__atomic_compare_exchange_n(&stage_base->pop_idx,&pop_idx,pop_idx+1,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED)){
+          *item_base_base=cell_base->item_base;
+          __atomic_store_n(&cell_base->sequence,pop_idx+cell_idx_max+1,__ATOMIC_RELEASE);
+          return 0;
+        }
+      }else if(delta<0){
+        return 1;
+      }else{
+        pop_idx=__atomic_load_n(&stage_base->pop_idx,__ATOMIC_RELAXED);
+      }
+    }while(1);
+  }
+
+  void
+  spawn_multi_pipe_queue_push(spawn_pipe_stage_t *stage_base,u8 *item_base){
+/*
+Enqueue an item to the input queue of a pipeline stage, waiting as long as the queue is full. This is how back-pressure propagates upstream. Do not call from outside Spawn.
+
+In:
+
+  *stage_base is the stage whose input queue to push.
+
+  item_base is the item.
+
+Out:
+
+  The item has been enqueued.
+*/
+    u32 backoff_count;
+    spawn_pipe_cell_t *cell_base;
+    u64 cell_idx_max;
+    i64 delta;
+    u64 push_idx;
+    u64 sequence;
+
+    backoff_count=0;
+    cell_idx_max=stage_base->cell_idx_max;
+    push_idx=__atomic_load_n(&stage_base->push_idx,__ATOMIC_RELAXED);
+    do{
+      cell_base=&stage_base->cell_list_base[push_idx&cell_idx_max];
+      sequence=__atomic_load_n(&cell_base->sequence,__ATOMIC_ACQUIRE);
+      delta=(i64)(sequence-push_idx);
+      if(!delta){
+        if(__atomic_compare_exchange_n(&stage_base->push_idx,&push_idx,push_idx+1,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED)){
+          cell_base->item_base=item_base;
+          __atomic_store_n(&cell_base->sequence,push_idx+1,__ATOMIC_RELEASE);
+          return;
+        }
+      }else if(delta<0){
+        spawn_multi_backoff(&backoff_count);
+        push_idx=__atomic_load_n(&stage_base->push_idx,__ATOMIC_RELAXED);
+      }else{
+        push_idx=__atomic_load_n(&stage_base->push_idx,__ATOMIC_RELAXED);
+      }
+    }while(1);
+  }
+
+  void *
+  spawn_multi_pipe_worker(void *pipe_context_base_void){
+/*
+Process items from the input queue of a pipeline stage until the stage upstream of it has retired and the queue is empty. This is the start routine of each pipeline worker pthread. Do not call from outside Spawn.
+
+In:
+
+  pipe_context_base_void is a (spawn_pipe_context_t *) belonging to the worker.
+
+Out:
+
+  Returns NULL, for compatibility with pthread_create().
+*/
+    u32 backoff_count;
+    void (*function_base)(spawn_pipe_context_t *);
+    u8 *item_base;
+    spawn_pipe_context_t *pipe_context_base;
+    spawn_pipe_stage_t *stage_base;
+
+    pipe_context_base=(spawn_pipe_context_t *)(pipe_context_base_void);
+    stage_base=&((spawn_pipe_t *)(pipe_context_base->pipe_base))->stage_list_base[pipe_context_base->stage_idx];
+    function_base=stage_base->function_base;
+    backoff_count=0;
+    do{
+      if(!spawn_multi_pipe_queue_pop(stage_base,&item_base)){
+        backoff_count=0;
+        pipe_context_base->item_base=item_base;
+        function_base(pipe_context_base);
+      }else if(__atomic_load_n(&stage_base->upstream_done_status,__ATOMIC_ACQUIRE)){
+/*
+Upstream is done, but it might have pushed an item after we found the queue empty, and before it was done. So look one more time.
+*/
+        if(spawn_multi_pipe_queue_pop(stage_base,&item_base)){
+          break;
+        }
+        pipe_context_base->item_base=item_base;
+        function_base(pipe_context_base);
+      }else{
+        spawn_multi_backoff(&backoff_count);
+      }
+    }while(1);
+    return NULL;
+  }
+
+  u8
+  spawn_multi_pipe_push(spawn_pipe_context_t *pipe_context_base,u8 *item_base){
+/*
+Pass an item from a pipeline stage to the next stage, waiting if the next stage's input queue is full.
+
+In:
+
+  *pipe_context_base is as passed to the stage function.
+
+  item_base is the item, which is opaque to Spawn. Typically, it points to a buffer allocated by the first stage and freed by the last.
+
+Out:
+
+  Returns 1 if this is the last stage, so there's nowhere to push to, else 0.
+*/
+    spawn_pipe_t *pipe_base;
+    u32 stage_idx;
+    u8 status;
+
+    pipe_base=(spawn_pipe_t *)(pipe_context_base->pipe_base);
+    stage_idx=pipe_context_base->stage_idx;
+    status=(stage_idx==pipe_base->stage_idx_max);
+    if(!status){
+      spawn_multi_pipe_queue_push(&pipe_base->stage_list_base[stage_idx+1],item_base);
+    }
+    return status;
+  }
+
+  u8
+  spawn_multi_pipe_feed(spawn_pipe_t *pipe_base,u8 *item_base){
+/*
+Feed an item to the first stage of a pipeline, waiting if its input queue is full. Call only from the thread which called spawn_multi_pipe_init().
+
+In:
+
+  *pipe_base is as returned by spawn_multi_pipe_init().
+
+  item_base is as defined in spawn_multi_pipe_push():In.
+
+Out:
+
+  Returns 1 if the pipeline has already been retired, else 0.
+*/
+    u8 status;
+
+    status=pipe_base->stage_list_base->upstream_done_status;
+    if(!status){
+      spawn_multi_pipe_queue_push(pipe_base->stage_list_base,item_base);
+    }
+    return status;
+  }
+
+  void
+  spawn_multi_pipe_retire_all(spawn_pipe_t *pipe_base){
+/*
+Signal the end of the input stream, and wait for every item to drain through every stage of a pipeline. After this, the pipeline can only be freed.
+
+In:
+
+  *pipe_base is as returned by spawn_multi_pipe_init().
+
+Out:
+
+  All pipeline workers have finished.
+*/
+    spawn_pipe_stage_t *stage_base;
+    u32 stage_idx;
+    u32 worker_idx;
+
+    stage_idx=0;
+    do{
+      stage_base=&pipe_base->stage_list_base[stage_idx];
+      __atomic_store_n(&stage_base->upstream_done_status,1,__ATOMIC_RELEASE);
+      for(worker_idx=0;worker_idx<stage_base->worker_launch_count;worker_idx++){
+        while(pthread_join(stage_base->pthread_list_base[worker_idx],NULL));
+      }
+      stage_base->worker_launch_count=0;
+    }while((stage_idx++)!=pipe_base->stage_idx_max);
+    return;
+  }
+
+  void
+  spawn_multi_pipe_free(spawn_pipe_t *pipe_base){
+/*
+Free a pipeline, retiring it first if necessary.
+
+In:
+
+  pipe_base is NULL, or as returned by spawn_multi_pipe_init().
+*/
+    spawn_pipe_stage_t *stage_base;
+    u32 stage_idx;
+
+    if(pipe_base){
+      spawn_multi_pipe_retire_all(pipe_base);
+      stage_idx=0;
+      do{
+        stage_base=&pipe_base->stage_list_base[stage_idx];
+        spawn_free(stage_base->cell_list_base);
+        spawn_free(stage_base->pipe_context_list_base);
+        spawn_free(stage_base->pthread_list_base);
+      }while((stage_idx++)!=pipe_base->stage_idx_max);
+      spawn_free(pipe_base->stage_list_base);
+      spawn_free(pipe_base);
+    }
+    return;
+  }
+
+  spawn_pipe_t *
+  spawn_multi_pipe_init(void (**function_list_base)(spawn_pipe_context_t *),u8 *readonly_string_base,u32 stage_idx_max,u32 *worker_idx_max_list_base,u8 queue_size_log2){
+/*
+Initialize and start a pipeline, which is a chain of stages, each with its own function and its own fixed number of workers, connected by bounded lock-free queues. Unlike spawn_multi(), workers are persistent pthreads which process one item after another, so the launch overhead is paid only once per worker. Items are processed in no particular order. When a queue fills up, the stage feeding it waits, so that back-pressure propagates all the way up to spawn_multi_pipe_feed(). Idle workers poll their queues with exponential backoff, sleeping at most about 1 ms at a time.
+
+In:
+
+  function_list_base is the base of (stage_idx_max+1) stage functions, each of which accepts a (spawn_pipe_context_t *) and has no return value. spawn_pipe_context_t.item_base is the item to process, which the function may pass downstream with spawn_multi_pipe_push(). The other members of spawn_pipe_context_t are analogous to those of spawn_simulthread_context_t, with worker_idx playing the role of simulthread_idx within each stage.
+
+  readonly_string_base is as defined in spawn_multi_init():In.
+
+  stage_idx_max is 1 less than the number of stages.
+
+  worker_idx_max_list_base is the base of (stage_idx_max+1) values, each of which is 1 less than the number of workers in the corresponding stage. This is the per-stage analog of simulthread_idx_max.
+
+  queue_size_log2 is the log2 of the number of items which each input queue can hold. At most 31.
+
+Out:
+
+  Returns NULL on failure, else a (spawn_pipe_t *) for use with spawn_multi_pipe_feed(), spawn_multi_pipe_retire_all(), and spawn_multi_pipe_free().
+*/
+    u64 cell_count;
+    u64 cell_idx;
+    spawn_pipe_context_t *pipe_context_base;
+    spawn_pipe_t *pipe_base;
+    spawn_pipe_stage_t *stage_base;
+    u32 stage_idx;
+    u64 stage_list_size;
+    u8 status;
+    u32 worker_idx;
+    u64 worker_list_size;
+
+    stage_list_size=stage_idx_max;
+    stage_list_size++;
+    stage_list_size*=sizeof(spawn_pipe_stage_t);
+    pipe_base=NULL;
+    if((queue_size_log2<=U32_BIT_MAX)&&(stage_list_size<=ULONG_MAX)){
+      pipe_base=(spawn_pipe_t *)(spawn_malloc(sizeof(spawn_pipe_t)-1));
+    }
+    if(pipe_base){
+      pipe_base->stage_list_base=(spawn_pipe_stage_t *)(spawn_malloc((ULONG)(stage_list_size-1)));
+      pipe_base->readonly_string_base=readonly_string_base;
+      pipe_base->stage_idx_max=stage_idx_max;
+      if(!pipe_base->stage_list_base){
+        spawn_free(pipe_base);
+        pipe_base=NULL;
+      }
+    }
+    if(pipe_base){
+      memset(pipe_base->stage_list_base,0,(size_t)(stage_list_size));
+      cell_count=1ULL<<queue_size_log2;
+      status=0;
+      stage_idx=0;
+      do{
+        stage_base=&pipe_base->stage_list_base[stage_idx];
+        stage_base->function_base=function_list_base[stage_idx];
+        stage_base->cell_idx_max=cell_count-1;
+        stage_base->worker_idx_max=worker_idx_max_list_base[stage_idx];
+        worker_list_size=stage_base->worker_idx_max;
+        worker_list_size++;
+        if(((cell_count*sizeof(spawn_pipe_cell_t))<=ULONG_MAX)&&((worker_list_size*sizeof(spawn_pipe_context_t))<=ULONG_MAX)&&((worker_list_size*sizeof(pthread_t))<=ULONG_MAX)){
+          stage_base->cell_list_base=(spawn_pipe_cell_t *)(spawn_malloc((ULONG)((cell_count*sizeof(spawn_pipe_cell_t))-1)));
+          stage_base->pipe_context_list_base=(spawn_pipe_context_t *)(spawn_malloc((ULONG)((worker_list_size*sizeof(spawn_pipe_context_t))-1)));
+          stage_base->pthread_list_base=(pthread_t *)(spawn_malloc((ULONG)((worker_list_size*sizeof(pthread_t))-1)));
+        }
+        status=!(stage_base->cell_list_base&&stage_base->pipe_context_list_base&&stage_base->pthread_list_base);
+        if(!status){
+          cell_idx=0;
+          do{
+            stage_base->cell_list_base[cell_idx].sequence=cell_idx;
+          }while((cell_idx++)!=stage_base->cell_idx_max);
+        }
+      }while((!status)&&((stage_idx++)!=stage_idx_max));
+/*
+Start the workers only once every queue exists, because a worker may push downstream as soon as it starts.
+*/
+      if(!status){
+        stage_idx=0;
+        do{
+          stage_base=&pipe_base->stage_list_base[stage_idx];
+          worker_idx=0;
+          do{
+            pipe_context_base=&stage_base->pipe_context_list_base[worker_idx];
+            pipe_context_base->item_base=NULL;
+            pipe_context_base->readonly_string_base=readonly_string_base;
+            pipe_context_base->pipe_base=pipe_base;
+            pipe_context_base->stage_idx=stage_idx;
+            pipe_context_base->worker_idx=worker_idx;
+            status=!!pthread_create(&stage_base->pthread_list_base[worker_idx],NULL,spawn_multi_pipe_worker,pipe_context_base);
+            if(!status){
+              stage_base->worker_launch_count++;
+            }
+          }while((!status)&&((worker_idx++)!=stage_base->worker_idx_max));
+        }while((!status)&&((stage_idx++)!=stage_idx_max));
+      }
+      if(status){
+        spawn_multi_pipe_free(pipe_base);
+        pipe_base=NULL;
+      }
+    }
+    return pipe_base;
+  }
+#else
+  void
+  spawn_mono_profile_free(spawn_t *spawn_base){
+/*
+Disable profiling and free its storage, if any.
+
+In:
+
+  *spawn_base is as returned by spawn_mono_init().
+
+Out:
+
+  spawn_base->profile_state_base is NULL.
+*/
+    spawn_profile_state_t *profile_state_base;
+
+    profile_state_base=spawn_base->profile_state_base;
+    if(profile_state_base){
+      spawn_free(profile_state_base->task_list_base);
+      spawn_free(profile_state_base);
+      spawn_base->profile_state_base=NULL;
+    }
+    return;
+  }
+
+  void
+  spawn_mono_profile_reset(spawn_t *spawn_base){
+/*
+Discard all profiled tasks, and restart the master's serial time clock from now.
+
+In:
+
+  *spawn_base is as returned by spawn_mono_init().
+
+Out:
+
+  No tasks have been profiled. If profiling isn't enabled, then nothing happens.
+*/
+    spawn_profile_state_t *profile_state_base;
+
+    profile_state_base=spawn_base->profile_state_base;
+    if(profile_state_base){
+      profile_state_base->end_nanoseconds=spawn_nanosecond_get();
+      profile_state_base->task_count=0;
+      profile_state_base->overflow_status=0;
+    }
+    return;
+  }
+
+  u8
+  spawn_mono_profile_enable(spawn_t *spawn_base){
+/*
+Start recording the duration of every thread, and the master's serial time between threads, so that spawn_mono_profile_predict() can forecast how the same workload would scale under spawn_multi(). Profiling persists across spawn_mono_rewind(), so that several passes can be profiled as one workload.
+
+In:
+
+  *spawn_base is as returned by spawn_mono_init().
+
+Out:
+
+  Returns 1 on failure due to insufficient memory, else 0.
+*/
+    spawn_profile_state_t *profile_state_base;
+    u8 status;
+
+    spawn_mono_profile_free(spawn_base);
+    status=1;
+    profile_state_base=(spawn_profile_state_t *)(spawn_malloc(sizeof(spawn_profile_state_t)-1));
+    if(profile_state_base){
+      profile_state_base->task_list_base=(spawn_profile_task_t *)(spawn_malloc(((SPAWN_PROFILE_TASK_IDX_MAX_MIN+1)*sizeof(spawn_profile_task_t))-1));
+      if(profile_state_base->task_list_base){
+        profile_state_base->task_idx_max=SPAWN_PROFILE_TASK_IDX_MAX_MIN;
+        spawn_base->profile_state_base=profile_state_base;
+        spawn_mono_profile_reset(spawn_base);
+        status=0;
+      }else{
+        spawn_free(profile_state_base);
+      }
+    }
+    return status;
+  }
+
+  void
+  spawn_mono_execute(spawn_t *spawn_base,spawn_simulthread_context_t *simulthread_context_base){
+/*
+Run one thread, recording its profile if enabled. Do not call from outside Spawn.
+
+In:
+
+  *spawn_base is as returned by spawn_mono_init().
+
+  *simulthread_context_base is the context of its only simulthread, with thread_idx set.
+
+Out:
+
+  The thread has run.
+*/
+    u64 begin_nanoseconds;
+    u64 end_nanoseconds;
+    spawn_profile_state_t *profile_state_base;
+    spawn_profile_task_t *task_base;
+    ULONG task_count;
+    spawn_profile_task_t *task_list_base;
+    u64 task_list_size;
+
+    profile_state_base=spawn_base->profile_state_base;
+    if(!profile_state_base){
+      spawn_simulthread_execute(simulthread_context_base);
+      return;
+    }
+    begin_nanoseconds=spawn_nanosecond_get();
+    spawn_simulthread_execute(simulthread_context_base);
+    end_nanoseconds=spawn_nanosecond_get();
+    task_count=profile_state_base->task_count;
+    if((task_count>profile_state_base->task_idx_max)&&!profile_state_base->overflow_status){
+/*
+Double the task list. If that fails, stop profiling rather than fail the thread, and let spawn_mono_profile_predict() report the problem.
+*/
+      task_list_base=NULL;
+      task_list_size=((u64)(profile_state_base->task_idx_max)+1)*sizeof(spawn_profile_task_t)<<1;
+      if(task_list_size<=ULONG_MAX){
+        task_list_base=(spawn_profile_task_t *)(spawn_malloc((ULONG)(task_list_size-1)));
+      }
+      if(task_list_base){
+        memcpy(task_list_base,profile_state_base->task_list_base,(size_t)(task_list_size>>1));
+        spawn_free(profile_state_base->task_list_base);
+        profile_state_base->task_list_base=task_list_base;
+        profile_state_base->task_idx_max=(profile_state_base->task_idx_max<<1)+1;
+      }else{
+        profile_state_base->overflow_status=1;
+      }
+    }
+    if(!profile_state_base->overflow_status){
+      task_base=&profile_state_base->task_list_base[task_count];
+      task_base->duration_nanoseconds=end_nanoseconds-begin_nanoseconds;
+      task_base->gap_nanoseconds=begin_nanoseconds-profile_state_base->end_nanoseconds;
+      task_base->thread_idx=simulthread_context_base->thread_idx;
+      profile_state_base->task_count=task_count+1;
+    }
+    profile_state_base->end_nanoseconds=spawn_nanosecond_get();
+    return;
+  }
+
+  u8
+  spawn_mono_profile_predict(spawn_t *spawn_base,u32 simulthread_idx_max,u64 launch_nanoseconds,spawn_profile_prediction_t *prediction_base){
+/*
+Forecast the behavior of the profiled workload under spawn_multi_one() with a given number of simulthreads, by replaying the profile through the same scheduling policy: the master does its serial work, retires the oldest simulthread if all are active, then pays the launch cost, after which the new thread runs for its profiled duration. Each simulthread is assumed to have a CPU of its own, and tasks are assumed not to slow each other down, so treat the result as an upper bound on speed-up.
+
+In:
+
+  *spawn_base is as returned by spawn_mono_init().
+
+  simulthread_idx_max is as defined in spawn_multi_init():In.
+
+  launch_nanoseconds is the master's cost of launching one thread, perhaps 10000 to 100000, depending on the OS.
+
+  *prediction_base is writable.
+
+Out:
+
+  Returns 1 on failure because profiling isn't enabled, or due to insufficient memory, including if the profile was truncated for that reason, else 0.
+
+  *prediction_base contains the forecast if the return value is 0, else undefined.
+*/
+    u64 busy_nanoseconds;
+    u64 end_nanoseconds;
+    u64 *end_nanoseconds_list_base;
+    u64 gap_nanoseconds;
+    u64 makespan_nanoseconds;
+    u64 master_nanoseconds;
+    spawn_profile_state_t *profile_state_base;
+    u64 serial_nanoseconds;
+    u32 simulthread_active_count;
+    u32 simulthread_launch_idx;
+    u32 simulthread_retire_idx;
+    u8 status;
+    spawn_profile_task_t *task_base;
+    ULONG task_count;
+    ULONG task_idx;
+
+    profile_state_base=spawn_base->profile_state_base;
+    status=1;
+    if(profile_state_base){
+      status=profile_state_base->overflow_status;
+    }
+    end_nanoseconds_list_base=NULL;
+    if(!status){
+      end_nanoseconds_list_base=(u64 *)(spawn_malloc((ULONG)((((u64)(simulthread_idx_max)+1)<<U64_SIZE_LOG2)-1)));
+      status=!end_nanoseconds_list_base;
+    }
+    if(!status){
+      busy_nanoseconds=0;
+      gap_nanoseconds=0;
+      makespan_nanoseconds=0;
+      master_nanoseconds=0;
+      simulthread_active_count=0;
+      simulthread_launch_idx=0;
+      simulthread_retire_idx=0;
+      task_count=profile_state_base->task_count;
+      for(task_idx=0;task_idx<task_count;task_idx++){
+        task_base=&profile_state_base->task_list_base[task_idx];
+        busy_nanoseconds+=task_base->duration_nanoseconds;
+        gap_nanoseconds+=task_base->gap_nanoseconds;
+        master_nanoseconds+=task_base->gap_nanoseconds;
+        if(simulthread_active_count>simulthread_idx_max){
+          master_nanoseconds=MAX(master_nanoseconds,end_nanoseconds_list_base[simulthread_retire_idx]);
+          simulthread_retire_idx=(simulthread_retire_idx!=simulthread_idx_max)?(simulthread_retire_idx+1):0;
+          simulthread_active_count--;
+        }
+        master_nanoseconds+=launch_nanoseconds;
+        end_nanoseconds=master_nanoseconds+task_base->duration_nanoseconds;
+        end_nanoseconds_list_base[simulthread_launch_idx]=end_nanoseconds;
+        makespan_nanoseconds=MAX(makespan_nanoseconds,end_nanoseconds);
+        simulthread_launch_idx=(simulthread_launch_idx!=simulthread_idx_max)?(simulthread_launch_idx+1):0;
+        simulthread_active_count++;
+      }
+      spawn_free(end_nanoseconds_list_base);
+      makespan_nanoseconds=MAX(makespan_nanoseconds,master_nanoseconds);
+      serial_nanoseconds=busy_nanoseconds+gap_nanoseconds;
+      prediction_base->busy_nanoseconds=busy_nanoseconds;
+      prediction_base->makespan_nanoseconds=makespan_nanoseconds;
+      prediction_base->serial_nanoseconds=serial_nanoseconds;
+      prediction_base->task_count=task_count;
+/*
+The master's serial work and launch costs can't be parallelized, so they bound the speed-up regardless of the number of simulthreads.
+*/
+      prediction_base->amdahl_milli=U64_MAX;
+      gap_nanoseconds+=(u64)(task_count)*launch_nanoseconds;
+      if(gap_nanoseconds){
+        prediction_base->amdahl_milli=serial_nanoseconds*1000/gap_nanoseconds;
+      }
+      prediction_base->speedup_milli=0;
+      prediction_base->utilisation_milli=0;
+      if(makespan_nanoseconds){
+        prediction_base->speedup_milli=serial_nanoseconds*1000/makespan_nanoseconds;
+        prediction_base->utilisation_milli=busy_nanoseconds*1000/makespan_nanoseconds/((u64)(simulthread_idx_max)+1);
+      }
+    }
+    return status;
+  }
+
+  u8
+  spawn_mono_profile_print(spawn_t *spawn_base,FILE *file_base,u32 simulthread_idx_max,u64 launch_nanoseconds){
+/*
+Print a text report of spawn_mono_profile_predict() forecasts for 1, 2, 4, 8, etc. simulthreads, up to and including (simulthread_idx_max+1).
+
+In:
+
+  *spawn_base is as returned by spawn_mono_init().
+
+  *file_base is the stream to which to print, for example stdout.
+
+  simulthread_idx_max is the largest value to forecast for, as defined in spawn_multi_init():In.
+
+  launch_nanoseconds is as defined in spawn_mono_profile_predict():In.
+
+Out:
+
+  Returns 1 on failure because profiling isn't enabled, in which case a note to that effect has been printed, or due to insufficient memory, else 0.
+*/
+    spawn_profile_prediction_t prediction;
+    spawn_profile_state_t *profile_state_base;
+    u32 simulthread_count;
+    u8 status;
+    spawn_profile_task_t *task_base;
+    ULONG task_idx;
+    spawn_profile_task_t *task_slowest_base;
+
+    profile_state_base=spawn_base->profile_state_base;
+    if(!profile_state_base){
+      fprintf(file_base,"Spawn profiling is not enabled.\n");
+      return 1;
+    }
+    status=spawn_mono_profile_predict(spawn_base,0,launch_nanoseconds,&prediction);
+    if(!status){
+      task_slowest_base=NULL;
+      for(task_idx=0;task_idx<profile_state_base->task_count;task_idx++){
+        task_base=&profile_state_base->task_list_base[task_idx];
+        if((!task_slowest_base)||(task_slowest_base->duration_nanoseconds<task_base->duration_nanoseconds)){
+          task_slowest_base=task_base;
+        }
+      }
+      fprintf(file_base,"tasks %llu, serial %llu ns, busy %llu ns",(unsigned long long)(prediction.task_count),(unsigned long long)(prediction.serial_nanoseconds),(unsigned long long)(prediction.busy_nanoseconds));
+      if(task_slowest_base){
+        fprintf(file_base,", slowest thread_idx %llu at %llu ns",(unsigned long long)(task_slowest_base->thread_idx),(unsigned long long)(task_slowest_base->duration_nanoseconds));
+      }
+      if(prediction.amdahl_milli!=U64_MAX){
+        fprintf(file_base,", speed-up limit %llu.%03llu\n",(unsigned long long)(prediction.amdahl_milli/1000),(unsigned long long)(prediction.amdahl_milli%1000));
+      }else{
+        fprintf(file_base,", speed-up limit n/a\n");
+      }
+      fprintf(file_base,"%11s %20s %10s %11s\n","simulthread","makespan_ns","speed-up","utilisation");
+      simulthread_count=1;
+      do{
+        status=spawn_mono_profile_predict(spawn_base,simulthread_count-1,launch_nanoseconds,&prediction);
+        if(status){
+          break;
+        }
+        fprintf(file_base,"%11lu %20llu %6llu.%03llu %7llu.%03llu\n",(unsigned long)(simulthread_count),(unsigned long long)(prediction.makespan_nanoseconds),(unsigned long long)(prediction.speedup_milli/1000),(unsigned long long)(prediction.speedup_milli%1000),(unsigned long long)(prediction.utilisation_milli/1000),(unsigned long long)(prediction.utilisation_milli%1000));
+        if((simulthread_count-1)==simulthread_idx_max){
+          break;
+        }
+        simulthread_count=(u32)(MIN((u64)(simulthread_count)<<1,(u64)(simulthread_idx_max)+1));
+      }while(1);
+    }
+    return status;
+  }
+
+  u8
+  spawn_mono_one(spawn_t *spawn_base,ULONG unique_idx){
+/*
+Monothreaded emulation of spawn_multi_one() for verification purposes or unicore environments.
+
+In:
+
+  unique_idx is as defined in spawn_multi_one():In.
+
+  *spawn_base is as returned by spawn_mono_init().
+
+Out:
+
+  Returns 0 for compatibility with spawn_multi_one().
+
+  The caller must not call any other Spawn function except this one, until spawn_mono_rewind() or spawn_mono_free() has been called.
+*/
+    spawn_simulthread_context_t *simulthread_context_base;
+    spawn_simulthread_t *simulthread_list_base;
+
+    if(!spawn_base->stop_status){
+      simulthread_list_base=spawn_base->simulthread_list_base;
+      simulthread_context_base=&simulthread_list_base->context;
+      simulthread_context_base->thread_idx=unique_idx;
+      spawn_mono_execute(spawn_base,simulthread_context_base);
+    }
+    return 0;
+  }
+
+  void
+  spawn_mono_bulk(spawn_t *spawn_base,ULONG *idx_list_base,ULONG *bitmap_base,ULONG item_idx_max){
+/*
+Monothreaded emulation of spawn_multi_bulk(), which runs the thread indexes in order, calling the prefetch function, if any, a fixed distance ahead. Do not call from outside Spawn.
+
+In:
+
+  All inputs are as defined in spawn_multi_bulk():In, except that *spawn_base is as returned by spawn_mono_init().
+
+Out:
+
+  Every thread_idx has been run.
+*/
+    ULONG item_idx;
+    ULONG item_prefetch_idx;
+    u32 prefetch_count;
+    void (*prefetch_function_base)(spawn_simulthread_context_t *,ULONG);
+    u32 prefetch_pending_count;
+    spawn_simulthread_context_t *simulthread_context_base;
+    ULONG thread_idx;
+    ULONG thread_prefetch_idx;
+
+    simulthread_context_base=&spawn_base->simulthread_list_base->context;
+    spawn_base->bulk_bitmap_base=bitmap_base;
+    spawn_base->bulk_idx_list_base=idx_list_base;
+    item_idx=0;
+    item_prefetch_idx=0;
+    prefetch_pending_count=0;
+    prefetch_function_base=spawn_base->prefetch_function_base;
+    if(prefetch_function_base){
+      prefetch_count=spawn_base->prefetch_count;
+      while(prefetch_count&&!spawn_bulk_next(spawn_base,&item_prefetch_idx,item_idx_max,&thread_prefetch_idx)){
+        prefetch_function_base(simulthread_context_base,thread_prefetch_idx);
+        prefetch_count--;
+        prefetch_pending_count++;
+      }
+    }
+/*
+As in spawn_bulk_execute(), after a stop, run only the indexes which have already been prefetched.
+*/
+    while(!(((spawn_base->stop_status)&&!prefetch_pending_count)||spawn_bulk_next(spawn_base,&item_idx,item_idx_max,&thread_idx))){
+      if(prefetch_function_base&&(!spawn_base->stop_status)&&!spawn_bulk_next(spawn_base,&item_prefetch_idx,item_idx_max,&thread_prefetch_idx)){
+        prefetch_function_base(simulthread_context_base,thread_prefetch_idx);
+        prefetch_pending_count++;
+      }
+      if(prefetch_pending_count){
+        prefetch_pending_count--;
+      }
+      simulthread_context_base->thread_idx=thread_idx;
+      spawn_mono_execute(spawn_base,simulthread_context_base);
+    }
+    spawn_base->bulk_bitmap_base=NULL;
+    spawn_base->bulk_idx_list_base=NULL;
+    return;
+  }
+
+  u8
+  spawn_mono(spawn_t *spawn_base,ULONG thread_idx_max){
+/*
+Monothreaded emulation of spawn_multi() for verification purposes or unicore environments.
+
+In:
+
+  thread_idx_max is as defined in spawn_multi():In.
+
+  *spawn_base is as returned by spawn_mono_init().
+
+Out:
+
+  Returns 0 for compatibility with spawn_multi().
+*/
+    ULONG i;
+    spawn_simulthread_context_t *simulthread_context_base;
+    spawn_simulthread_t *simulthread_list_base;
+
+    spawn_stat_plan(spawn_base,NULL,thread_idx_max);
+    if(spawn_base->prefetch_function_base){
+      spawn_mono_bulk(spawn_base,NULL,NULL,thread_idx_max);
+      return 0;
+    }
+    simulthread_list_base=spawn_base->simulthread_list_base;
+    simulthread_context_base=&simulthread_list_base->context;
+    i=0;
+    do{
+      if(spawn_base->stop_status){
+        break;
+      }
+      simulthread_context_base->thread_idx=i;
+      spawn_mono_execute(spawn_base,simulthread_context_base);
+    }while((i++)!=thread_idx_max);
+    return 0;
+  }
+
+  u8
+  spawn_mono_list(spawn_t *spawn_base,ULONG *idx_list_base,ULONG idx_idx_max,u8 sort_status){
+/*
+Monothreaded emulation of spawn_multi_list() for verification purposes or unicore environments.
+
+In:
+
+  All inputs are as defined in spawn_multi_list():In, except that *spawn_base is as returned by spawn_mono_init().
+
+Out:
+
+  Returns 0 for compatibility with spawn_multi_list().
+*/
+    spawn_stat_plan(spawn_base,NULL,idx_idx_max);
+    if(sort_status){
+      qsort(idx_list_base,(size_t)(idx_idx_max)+1,sizeof(ULONG),spawn_bulk_compare);
+    }
+    spawn_mono_bulk(spawn_base,idx_list_base,NULL,idx_idx_max);
+    return 0;
+  }
+
+  u8
+  spawn_mono_bitmap(spawn_t *spawn_base,ULONG *bitmap_base,ULONG bit_idx_max){
+/*
+Monothreaded emulation of spawn_multi_bitmap() for verification purposes or unicore environments.
+
+In:
+
+  All inputs are as defined in spawn_multi_bitmap():In, except that *spawn_base is as returned by spawn_mono_init().
+
+Out:
+
+  Returns 0 for compatibility with spawn_multi_bitmap().
+*/
+    spawn_stat_plan(spawn_base,bitmap_base,bit_idx_max);
+    spawn_mono_bulk(spawn_base,NULL,bitmap_base,bit_idx_max);
+    return 0;
+  }
+
+  u8
+  spawn_mono_deadline(spawn_t *spawn_base,ULONG thread_idx_max,u64 deadline_nanoseconds,u8 wrap_status,ULONG *done_bitmap_base){
+/*
+Monothreaded emulation of spawn_multi_deadline() for verification purposes or unicore environments.
+
+In:
+
+  All inputs are as defined in spawn_multi_deadline():In, except that *spawn_base is as returned by spawn_mono_init().
+
+Out:
+
+  Returns 0 for compatibility with spawn_multi_deadline().
+
+  *done_bitmap_base is as defined in spawn_multi_deadline():Out.
+*/
+    ULONG i;
+    spawn_simulthread_context_t *simulthread_context_base;
+    spawn_simulthread_t *simulthread_list_base;
+
+    spawn_stat_plan(spawn_base,NULL,thread_idx_max);
+    memset(done_bitmap_base,0,(size_t)(((thread_idx_max>>ULONG_BITS_LOG2)+1)<<ULONG_SIZE_LOG2));
+    spawn_deadline_set(spawn_base,deadline_nanoseconds);
+    spawn_base->deadline_wrap_status=wrap_status;
+    spawn_base->done_bitmap_base=done_bitmap_base;
+    simulthread_list_base=spawn_base->simulthread_list_base;
+    simulthread_context_base=&simulthread_list_base->context;
+    i=0;
+    do{
+      if(spawn_base->stop_status||spawn_deadline_passed_get(spawn_base)){
+        break;
+      }
+      simulthread_context_base->thread_idx=i;
+      spawn_mono_execute(spawn_base,simulthread_context_base);
+    }while((i++)!=thread_idx_max);
+    spawn_base->deadline_nanoseconds=0;
+    spawn_base->deadline_wrap_status=0;
+    spawn_base->done_bitmap_base=NULL;
+    spawn_base->stop_status&=(u8)(~SPAWN_STOP_DEADLINE);
+    return 0;
+  }
+
+  void
+  spawn_mono_free(spawn_t *spawn_base){
+    if(spawn_base){
+      spawn_memo_free(spawn_base);
+      spawn_perf_free(spawn_base);
+      spawn_mono_profile_free(spawn_base);
+      spawn_sink_close(spawn_base);
+      spawn_speculate_free(spawn_base);
+      spawn_stat_free(spawn_base);
+      spawn_io_free(spawn_base);
+      spawn_log_close(spawn_base);
+      spawn_free(spawn_base->simulthread_list_base);
+      spawn_free(spawn_base);
+    }
+    return;
+  }
+
+  void
+  spawn_mono_rewind(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base,spawn_t *spawn_base){
+/*
+Reset the Spawn engine without changing the memory map. It is not necessary to call this function unless a new function_base or readonly_string_base is to be used in a subsequent spawn_mono() or spawn_mono_one().
+
+In:
+
+  function_base is as defined in spawn_mono_init():In.
+
+  readonly_string_base is as defined in spawn_mono_init():In.
+
+  *spawn_base is as returned by spawn_mono_init().
+*/
+    spawn_simulthread_t *simulthread_list_base;
+
+    spawn_memo_rewind(spawn_base,function_base);
+    spawn_base->function_base=function_base;
+    spawn_base->stop_status=0;
+    simulthread_list_base=spawn_base->simulthread_list_base;
+    simulthread_list_base->context.readonly_string_base=readonly_string_base;
+    return;
+  }
+
+  spawn_t *
+  spawn_mono_init(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base){
+/*
+Initialize the Spawn engine for monothreaded mode.
+
+In:
+
+  function_base is as defined in spawn_multi_init():In.
+
+  readonly_string_base is as defined in spawn_multi_init():In
+
+Out:
+
+  Returns NULL on failure, else a (spawn_t *) for use with future calls to the Spawn engine.
+*/
+    spawn_simulthread_t *simulthread_list_base;
+    spawn_t *spawn_base;
+
+    simulthread_list_base=(spawn_simulthread_t *)(spawn_malloc(sizeof(spawn_simulthread_t)-1));
+    spawn_base=NULL;
+    if(simulthread_list_base){
+      spawn_base=(spawn_t *)(spawn_malloc(sizeof(spawn_t)-1));
+      if(spawn_base){
+        spawn_base->bulk_bitmap_base=NULL;
+        spawn_base->bulk_idx_list_base=NULL;
+        spawn_base->done_bitmap_base=NULL;
+        spawn_base->function_base=function_base;
+        spawn_base->io_ring_list_base=NULL;
+        spawn_base->log_state_base=NULL;
+        spawn_base->memo_state_base=NULL;
+        spawn_base->perf_state_base=NULL;
+        spawn_base->prefetch_function_base=NULL;
+        spawn_base->profile_state_base=NULL;
+        spawn_base->simulthread_list_base=simulthread_list_base;
+        spawn_base->sink_state_base=NULL;
+        spawn_base->speculate_state_base=NULL;
+        spawn_base->stat_base=NULL;
+        spawn_base->deadline_nanoseconds=0;
+        spawn_base->bulk_chunk_item_count=0;
+        spawn_base->bulk_item_idx_max=0;
+        spawn_base->stat_size=0;
+        spawn_base->prefetch_count=0;
+        spawn_base->simulthread_idx_max=0;
+        spawn_base->simulthread_limit_idx_max=0;
+        spawn_base->deadline_wrap_status=0;
+        spawn_base->stop_status=0;
+        simulthread_list_base->context.readonly_string_base=readonly_string_base;
+        simulthread_list_base->context.simulthread_idx=0;
+        simulthread_list_base->spawn_base=spawn_base;
+        simulthread_list_base->perf_group_fd=-1;
+      }else{
+        spawn_free(simulthread_list_base);
+      }
+    }
+    return spawn_base;
+  }
+
+  u8
+  spawn_mono_pipe_push(spawn_pipe_context_t *pipe_context_base,u8 *item_base){
+/*
+Monothreaded emulation of spawn_multi_pipe_push(), which runs the next stage immediately.
+
+In:
+
+  *pipe_context_base is as defined in spawn_multi_pipe_push():In.
+
+  item_base is as defined in spawn_multi_pipe_push():In.
+
+Out:
+
+  Returns as defined in spawn_multi_pipe_push():Out.
+*/
+    spawn_pipe_t *pipe_base;
+    spawn_pipe_stage_t *stage_base;
+    u32 stage_idx;
+    u8 status;
+
+    pipe_base=(spawn_pipe_t *)(pipe_context_base->pipe_base);
+    stage_idx=pipe_context_base->stage_idx;
+    status=(stage_idx==pipe_base->stage_idx_max);
+    if(!status){
+      stage_base=&pipe_base->stage_list_base[stage_idx+1];
+      stage_base->pipe_context_list_base->item_base=item_base;
+      stage_base->function_base(stage_base->pipe_context_list_base);
+    }
+    return status;
+  }
+
+  u8
+  spawn_mono_pipe_feed(spawn_pipe_t *pipe_base,u8 *item_base){
+/*
+Monothreaded emulation of spawn_multi_pipe_feed(), which runs the first stage immediately.
+
+In:
+
+  *pipe_base is as returned by spawn_mono_pipe_init().
+
+  item_base is as defined in spawn_multi_pipe_push():In.
+
+Out:
+
+  Returns 0 for compatibility with spawn_multi_pipe_feed().
+*/
+    spawn_pipe_stage_t *stage_base;
+
+    stage_base=pipe_base->stage_list_base;
+    stage_base->pipe_context_list_base->item_base=item_base;
+    stage_base->function_base(stage_base->pipe_context_list_base);
+    return 0;
+  }
+
+  void
+  spawn_mono_pipe_free(spawn_pipe_t *pipe_base){
+/*
+Monothreaded emulation of spawn_multi_pipe_free().
+
+In:
+
+  pipe_base is NULL, or as returned by spawn_mono_pipe_init().
+*/
+    u32 stage_idx;
+
+    if(pipe_base){
+      stage_idx=0;
+      do{
+        spawn_free(pipe_base->stage_list_base[stage_idx].pipe_context_list_base);
+      }while((stage_idx++)!=pipe_base->stage_idx_max);
+      spawn_free(pipe_base->stage_list_base);
+      spawn_free(pipe_base);
+    }
+    return;
+  }
+
+  spawn_pipe_t *
+  spawn_mono_pipe_init(void (**function_list_base)(spawn_pipe_context_t *),u8 *readonly_string_base,u32 stage_idx_max){
+/*
+Monothreaded emulation of spawn_multi_pipe_init(), in which each item passes through every stage before spawn_mono_pipe_feed() returns. There are no queues, and each stage has a single worker.
+
+In:
+
+  function_list_base is as defined in spawn_multi_pipe_init():In.
+
+  readonly_string_base is as defined in spawn_multi_pipe_init():In.
+
+  stage_idx_max is as defined in spawn_multi_pipe_init():In.
+
+Out:
+
+  Returns NULL on failure, else a (spawn_pipe_t *) for use with spawn_mono_pipe_feed() and spawn_mono_pipe_free().
+*/
+    spawn_pipe_context_t *pipe_context_base;
+    spawn_pipe_t *pipe_base;
+    u32 stage_idx;
+    u64 stage_list_size;
+    u8 status;
+
+    stage_list_size=stage_idx_max;
+    stage_list_size++;
+    stage_list_size*=sizeof(spawn_pipe_stage_t);
+    pipe_base=NULL;
+    if(stage_list_size<=ULONG_MAX){
+      pipe_base=(spawn_pipe_t *)(spawn_malloc(sizeof(spawn_pipe_t)-1));
+    }
+    if(pipe_base){
+      pipe_base->stage_list_base=(spawn_pipe_stage_t *)(spawn_malloc((ULONG)(stage_list_size-1)));
+      pipe_base->readonly_string_base=readonly_string_base;
+      pipe_base->stage_idx_max=stage_idx_max;
+      if(pipe_base->stage_list_base){
+        memset(pipe_base->stage_list_base,0,(size_t)(stage_list_size));
+        status=0;
+        stage_idx=0;
+        do{
+          pipe_context_base=(spawn_pipe_context_t *)(spawn_malloc(sizeof(spawn_pipe_context_t)-1));
+          pipe_base->stage_list_base[stage_idx].function_base=function_list_base[stage_idx];
+          pipe_base->stage_list_base[stage_idx].pipe_context_list_base=pipe_context_base;
+          status=!pipe_context_base;
+          if(!status){
+            pipe_context_base->item_base=NULL;
+            pipe_context_base->readonly_string_base=readonly_string_base;
+            pipe_context_base->pipe_base=pipe_base;
+            pipe_context_base->stage_idx=stage_idx;
+            pipe_context_base->worker_idx=0;
+          }
+        }while((!status)&&((stage_idx++)!=stage_idx_max));
+        if(status){
+          spawn_mono_pipe_free(pipe_base);
+          pipe_base=NULL;
+        }
+      }else{
+        spawn_free(pipe_base);
+        pipe_base=NULL;
+      }
+    }
+    return pipe_base;
+  }
+#endif
+
+void
+spawn_chunk_range_get(spawn_simulthread_context_t *simulthread_context_base,ULONG *item_idx_min_base,ULONG *item_idx_max_base){
+/*
+Get the range of items belonging to the chunk being processed by a spawn_chunk_run() thread. Do not call from outside Spawn.
+
+In:
+
+  *simulthread_context_base is as passed to the thread.
+
+  *item_idx_min_base is writable.
+
+  *item_idx_max_base is writable.
+
+Out:
+
+  *item_idx_min_base is the first item index of the chunk.
+
+  *item_idx_max_base is the last item index of the chunk.
+*/
+  spawn_chunk_t *chunk_base;
+  ULONG item_idx_min;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  item_idx_min=simulthread_context_base->thread_idx*chunk_base->chunk_item_count;
+  *item_idx_min_base=item_idx_min;
+  *item_idx_max_base=MIN(chunk_base->item_idx_max-item_idx_min,chunk_base->chunk_item_count-1)+item_idx_min;
+  return;
+}
+
+ULONG
+spawn_chunk_count_get(spawn_t *spawn_base,spawn_chunk_t *chunk_base){
+/*
+Decide how to split a list of items into chunks for spawn_chunk_run(), which calls this itself. Callers only need it in order to allocate per-chunk storage beforehand. Do not call from outside Spawn.
+
+In:
+
+  *chunk_base has item_idx_max and item_size set.
+
+  *spawn_base is as passed to spawn_chunk_run().
+
+Out:
+
+  Returns the maximum chunk index. chunk_base->chunk_item_count is the number of items per chunk, except possibly the last one.
+*/
+  u64 chunk_item_count_u64;
+  ULONG item_count_page;
+  long page_size;
+
+  page_size=sysconf(_SC_PAGESIZE);
+  page_size=MAX(page_size,1);
+  item_count_page=MAX((ULONG)(page_size)/chunk_base->item_size,1);
+  chunk_item_count_u64=((u64)(chunk_base->item_idx_max)/((u64)(spawn_base->simulthread_idx_max)+1))+1;
+  chunk_item_count_u64=((chunk_item_count_u64+item_count_page-1)/item_count_page)*item_count_page;
+  chunk_base->chunk_item_count=(ULONG)(MIN(chunk_item_count_u64,(u64)(chunk_base->item_idx_max)+1));
+  return chunk_base->item_idx_max/chunk_base->chunk_item_count;
+}
+
+u8
+spawn_chunk_run(spawn_t *spawn_base,void (*function_base)(spawn_simulthread_context_t *),spawn_chunk_t *chunk_base){
+/*
+Split a list of items into one chunk per simulthread and process them in parallel, using the Spawn engine with all of its instrumentation temporarily disabled. Chunks are page multiples when the item size divides the page size, so that, for first-touch NUMA page placement, each page is touched by exactly one thread. Without locality keys, that thread is unpinned, so its pages land on whichever node the OS happened to run it, and later threads have no affinity to that node: pages are merely spread across nodes, rather than placed near the simulthread which will use them. If locality keys are enabled, then each chunk is launched with its chunk index as its locality key, so subsequent threads launched with the same key will tend to run near the memory that the chunk touched. Do not call from outside Spawn.
+
+In:
+
+  function_base is the function to call on each chunk, which must call spawn_chunk_range_get() to find out which items to process.
+
+  *chunk_base has base, item_idx_max, and item_size set, and whatever else function_base requires. chunk_item_count will be set here.
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(), with no threads in flight.
+
+Out:
+
+  Returns 1 if not all chunks were processed due to a fatal error, else 0. The function, readonly string, and instrumentation of *spawn_base are restored. Other fields, such as the simulthread limit, keep any changes made meanwhile, and a stop requested before or during the run remains in effect.
+*/
+#ifdef PTHREAD
+  spawn_budget_state_t *budget_state_base;
+  ULONG chunk_idx;
+#endif
+  ULONG chunk_idx_max;
+  ULONG *done_bitmap_base;
+  void (*function_base_saved)(spawn_simulthread_context_t *);
+  spawn_memo_state_t *memo_state_base;
+  spawn_perf_state_t *perf_state_base;
+  void (*prefetch_function_base)(spawn_simulthread_context_t *,ULONG);
+#ifndef PTHREAD
+  spawn_profile_state_t *profile_state_base;
+#endif
+  u8 *readonly_string_base;
+  spawn_sink_state_t *sink_state_base;
+  spawn_speculate_state_t *speculate_state_base;
+  spawn_stat_t *stat_base;
+  u8 status;
+  u8 stop_status;
+
+  chunk_idx_max=spawn_chunk_count_get(spawn_base,chunk_base);
+/*
+Detach all instrumentation, so the chunks don't pollute statistics, caches, or output, then put everything back afterwards.
+*/
+  readonly_string_base=spawn_base->simulthread_list_base->context.readonly_string_base;
+  done_bitmap_base=spawn_base->done_bitmap_base;
+  function_base_saved=spawn_base->function_base;
+  memo_state_base=spawn_base->memo_state_base;
+  perf_state_base=spawn_base->perf_state_base;
+  prefetch_function_base=spawn_base->prefetch_function_base;
+  sink_state_base=spawn_base->sink_state_base;
+  speculate_state_base=spawn_base->speculate_state_base;
+  stat_base=spawn_base->stat_base;
+  stop_status=spawn_base->stop_status;
+  spawn_base->done_bitmap_base=NULL;
+  spawn_base->memo_state_base=NULL;
+  spawn_base->perf_state_base=NULL;
+  spawn_base->prefetch_function_base=NULL;
+  spawn_base->sink_state_base=NULL;
+  spawn_base->speculate_state_base=NULL;
+  spawn_base->stat_base=NULL;
+  SPAWN_REWIND(function_base,(u8 *)(chunk_base),spawn_base);
+#ifdef PTHREAD
+  budget_state_base=spawn_base->budget_state_base;
+  spawn_base->budget_state_base=NULL;
+  if(spawn_base->locality_state_base){
+    status=0;
+    chunk_idx=0;
+    do{
+      status=spawn_multi_one_keyed(spawn_base,chunk_idx,chunk_idx);
+    }while((!status)&&((chunk_idx++)!=chunk_idx_max));
+  }else{
+    status=spawn_multi(spawn_base,chunk_idx_max);
+  }
+  spawn_multi_retire_all(spawn_base);
+  spawn_base->budget_state_base=budget_state_base;
+#else
+  profile_state_base=spawn_base->profile_state_base;
+  spawn_base->profile_state_base=NULL;
+  status=spawn_mono(spawn_base,chunk_idx_max);
+  spawn_base->profile_state_base=profile_state_base;
+#endif
+  stop_status|=spawn_base->stop_status;
+  SPAWN_REWIND(function_base_saved,readonly_string_base,spawn_base);
+  spawn_base->done_bitmap_base=done_bitmap_base;
+  spawn_base->memo_state_base=memo_state_base;
+  spawn_base->perf_state_base=perf_state_base;
+  spawn_base->prefetch_function_base=prefetch_function_base;
+  spawn_base->sink_state_base=sink_state_base;
+  spawn_base->speculate_state_base=speculate_state_base;
+  spawn_base->stat_base=stat_base;
+  spawn_base->stop_status=stop_status;
+  return status;
+}
+
+void
+spawn_copy_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Copy one chunk for spawn_copy(). Do not call from outside Spawn.
+*/
+  spawn_chunk_t *chunk_base;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  memcpy(&chunk_base->base[item_idx_min],&chunk_base->source_base[item_idx_min],(size_t)(item_idx_max-item_idx_min)+1);
+  return;
+}
+
+u8
+spawn_copy(spawn_t *spawn_base,u8 *destination_base,u8 *source_base,ULONG size){
+/*
+Copy memory in parallel, so that the pages of the destination are first touched by the simulthreads, rather than the caller. As explained in spawn_chunk_run(), this spreads the pages across NUMA nodes, but doesn't place them near the threads which later use them, because nothing ties a later thread to the CPU which touched its pages. With spawn_multi_locality_enable(), the chunks are at least placed by locality key, so that later threads launched with matching keys tend to run on the same node. Must not be called while any threads are in flight.
+
+In:
+
+  destination_base is the base of the destination, which should be page-aligned for best results.
+
+  source_base is the base of the source, which must not overlap the destination.
+
+  size is the number of bytes to copy, which may be 0.
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(). Its function_base, readonly_string_base, and instrumentation are unaffected.
+
+Out:
+
+  Returns 1 on failure, in which case the destination is undefined, else 0.
+*/
+  spawn_chunk_t chunk;
+  u8 status;
+
+  status=0;
+  if(size){
+    chunk.base=destination_base;
+    chunk.source_base=source_base;
+    chunk.item_idx_max=size-1;
+    chunk.item_size=1;
+    status=spawn_chunk_run(spawn_base,spawn_copy_execute,&chunk);
+  }
+  return status;
+}
+
+void
+spawn_fill_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Fill one chunk for spawn_fill(). Do not call from outside Spawn.
+*/
+  spawn_chunk_t *chunk_base;
+  u8 *item_base;
+  ULONG item_idx;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+  ULONG item_size;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  item_base=chunk_base->item_base;
+  item_size=chunk_base->item_size;
+  if(!item_base){
+    memset(&chunk_base->base[item_idx_min*item_size],0,(size_t)((item_idx_max-item_idx_min+1)*item_size));
+  }else{
+    item_idx=item_idx_min;
+    do{
+      memcpy(&chunk_base->base[item_idx*item_size],item_base,(size_t)(item_size));
+    }while((item_idx++)!=item_idx_max);
+  }
+  return;
+}
+
+u8
+spawn_fill(spawn_t *spawn_base,u8 *base,ULONG item_idx_max,u8 *item_base,ULONG item_size){
+/*
+Fill a list of items in parallel, so that its pages are first touched by the simulthreads, rather than the caller. As explained in spawn_chunk_run(), this spreads the pages across NUMA nodes, but doesn't place them near the threads which later use them, because nothing ties a later thread to the CPU which touched its pages. With spawn_multi_locality_enable(), the chunks are at least placed by locality key, so that later threads launched with matching keys tend to run on the same node. Must not be called while any threads are in flight.
+
+In:
+
+  base is the base of the list, which should be page-aligned for best results.
+
+  item_idx_max is the maximum item index.
+
+  item_base is the base of the value to copy to every item, or NULL to zero the list.
+
+  item_size is the nonzero size of an item, which should divide the page size for best results.
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(). Its function_base, readonly_string_base, and instrumentation are unaffected.
+
+Out:
+
+  Returns 1 on failure, in which case the list is undefined, else 0.
+*/
+  spawn_chunk_t chunk;
+  u8 status;
+
+  chunk.base=base;
+  chunk.item_base=item_base;
+  chunk.item_idx_max=item_idx_max;
+  chunk.item_size=item_size;
+  status=spawn_chunk_run(spawn_base,spawn_fill_execute,&chunk);
+  return status;
+}
+
+void
+spawn_generate_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Generate one chunk for spawn_generate(). Do not call from outside Spawn.
+*/
+  spawn_chunk_t *chunk_base;
+  ULONG item_idx;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+  ULONG item_size;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  item_size=chunk_base->item_size;
+  item_idx=item_idx_min;
+  do{
+    chunk_base->generate_function_base(&chunk_base->base[item_idx*item_size],item_idx,chunk_base->readonly_string_base);
+  }while((item_idx++)!=item_idx_max);
+  return;
+}
+
+u8
+spawn_generate(spawn_t *spawn_base,u8 *base,ULONG item_idx_max,ULONG item_size,void (*generate_function_base)(u8 *,ULONG,u8 *),u8 *readonly_string_base){
+/*
+Initialize a list of items in parallel, each as a function of its index, so that its pages are first touched by the simulthreads, rather than the caller. As explained in spawn_chunk_run(), this spreads the pages across NUMA nodes, but doesn't place them near the threads which later use them, because nothing ties a later thread to the CPU which touched its pages. With spawn_multi_locality_enable(), the chunks are at least placed by locality key, so that later threads launched with matching keys tend to run on the same node. Must not be called while any threads are in flight.
+
+In:
+
+  base is the base of the list, which should be page-aligned for best results.
+
+  item_idx_max is the maximum item index.
+
+  item_size is the nonzero size of an item, which should divide the page size for best results.
+
+  generate_function_base is called once per item, with the base of the item, its index, and readonly_string_base. It may be called from any simulthread, concurrently with itself.
+
+  readonly_string_base is passed through to generate_function_base.
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(). Its function_base, readonly_string_base, and instrumentation are unaffected.
+
+Out:
+
+  Returns 1 on failure, in which case the list is undefined, else 0.
+*/
+  spawn_chunk_t chunk;
+  u8 status;
+
+  chunk.base=base;
+  chunk.generate_function_base=generate_function_base;
+  chunk.readonly_string_base=readonly_string_base;
+  chunk.item_idx_max=item_idx_max;
+  chunk.item_size=item_size;
+  status=spawn_chunk_run(spawn_base,spawn_generate_execute,&chunk);
+  return status;
+}
+
+void
+spawn_sort_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Sort one chunk in place for spawn_sort(). Do not call from outside Spawn.
+*/
+  spawn_chunk_t *chunk_base;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  qsort(&((ULONG *)(chunk_base->base))[item_idx_min],(size_t)(item_idx_max-item_idx_min)+1,sizeof(ULONG),spawn_bulk_compare);
+  return;
+}
+
+void
+spawn_merge_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Merge pairs of adjacent sorted runs for spawn_sort(), where each item of the chunk is a pair. Do not call from outside Spawn.
+*/
+  spawn_chunk_t *chunk_base;
+  ULONG *destination_base;
+  u64 idx0;
+  u64 idx1;
+  u64 idx_end0;
+  u64 idx_end1;
+  u64 item_count;
+  ULONG item_idx;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+  u64 list_idx;
+  u64 run_item_count;
+  ULONG *source_base;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  destination_base=(ULONG *)(chunk_base->base);
+  source_base=(ULONG *)(chunk_base->source_base);
+  item_count=(u64)(chunk_base->list_idx_max)+1;
+  run_item_count=chunk_base->run_item_count;
+  item_idx=item_idx_min;
+  do{
+    idx0=(u64)(item_idx)*(run_item_count<<1);
+    idx_end0=MIN(idx0+run_item_count,item_count);
+    idx1=idx_end0;
+    idx_end1=MIN(idx1+run_item_count,item_count);
+    list_idx=idx0;
+/*
+Take from the first run on ties, so that the merge is stable.
+*/
+    while(list_idx!=idx_end1){
+      if((idx1==idx_end1)||((idx0!=idx_end0)&&(source_base[idx0]<=source_base[idx1]))){
+        destination_base[list_idx]=source_base[idx0];
+        idx0++;
+      }else{
+        destination_base[list_idx]=source_base[idx1];
+        idx1++;
+      }
+      list_idx++;
+    }
+  }while((item_idx++)!=item_idx_max);
+  return;
+}
+
+u8
+spawn_sort(spawn_t *spawn_base,ULONG *list_base,ULONG idx_max){
+/*
+Sort a list of (ULONG)s into ascending order in parallel. Each simulthread sorts a chunk, then pairs of sorted runs are merged in parallel, doubling the run size each time, until one run remains. Must not be called while any threads are in flight.
+
+In:
+
+  list_base is the base of the list.
+
+  idx_max is the maximum index into list_base.
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(). Its function_base, readonly_string_base, and instrumentation are unaffected.
+
+Out:
+
+  Returns 1 on failure, in which case the list is a permutation of what it was, but its order is undefined, else 0.
+*/
+  spawn_chunk_t chunk;
+  ULONG *destination_base;
+  u64 list_size;
+  u64 pair_count;
+  u64 run_item_count;
+  ULONG *scratch_base;
+  ULONG *source_base;
+  u8 status;
+
+  chunk.base=(u8 *)(list_base);
+  chunk.item_idx_max=idx_max;
+  chunk.item_size=sizeof(ULONG);
+  status=spawn_chunk_run(spawn_base,spawn_sort_execute,&chunk);
+  run_item_count=chunk.chunk_item_count;
+  if((!status)&&(run_item_count<=idx_max)){
+    status=1;
+    list_size=((u64)(idx_max)+1)*sizeof(ULONG);
+    scratch_base=NULL;
+    if(list_size<=ULONG_MAX){
+      scratch_base=(ULONG *)(spawn_malloc((ULONG)(list_size-1)));
+    }
+    if(scratch_base){
+      destination_base=scratch_base;
+      source_base=list_base;
+      chunk.list_idx_max=idx_max;
+      do{
+        pair_count=((u64)(idx_max)+(run_item_count<<1))/(run_item_count<<1);
+        chunk.base=(u8 *)(destination_base);
+        chunk.source_base=(u8 *)(source_base);
+        chunk.item_idx_max=(ULONG)(pair_count-1);
+/*
+A pair is usually much larger than a page, so this prevents chunks from being rounded up to page multiples of pairs.
+*/
+        chunk.item_size=(ULONG)(MIN((run_item_count<<1)*sizeof(ULONG),ULONG_MAX));
+        chunk.run_item_count=(ULONG)(run_item_count);
+        status=spawn_chunk_run(spawn_base,spawn_merge_execute,&chunk);
+        source_base=destination_base;
+        destination_base=(ULONG *)(chunk.source_base);
+        run_item_count<<=1;
+      }while((!status)&&(run_item_count<=idx_max));
+      if(status){
+/*
+A failed pass only read from its source, which is therefore still a permutation of the list.
+*/
+        source_base=destination_base;
+      }
+      if(source_base!=list_base){
+/*
+If the parallel copy fails partway, then the complete result is still in the scratch list, so finish serially.
+*/
+        if(status||spawn_copy(spawn_base,(u8 *)(list_base),(u8 *)(source_base),(ULONG)(list_size))){
+          memcpy(list_base,source_base,(size_t)(list_size));
+        }
+      }
+      spawn_free(scratch_base);
+    }
+  }
+  return status;
+}
+
+void
+spawn_scan_sum_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Sum one chunk for spawn_scan(). Do not call from outside Spawn.
+*/
+  spawn_chunk_t *chunk_base;
+  ULONG item_idx;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+  ULONG *list_base;
+  ULONG sum;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  list_base=(ULONG *)(chunk_base->base);
+  sum=0;
+  item_idx=item_idx_min;
+  do{
+    sum+=list_base[item_idx];
+  }while((item_idx++)!=item_idx_max);
+  chunk_base->chunk_list_base[simulthread_context_base->thread_idx]=sum;
+  return;
+}
+
+void
+spawn_scan_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Replace one chunk with its prefix sums for spawn_scan(), starting from the sum of all previous chunks. Do not call from outside Spawn.
+*/
+  spawn_chunk_t *chunk_base;
+  u8 inclusive_status;
+  ULONG item_idx;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+  ULONG *list_base;
+  ULONG sum;
+  ULONG value;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  inclusive_status=chunk_base->inclusive_status;
+  list_base=(ULONG *)(chunk_base->base);
+  sum=chunk_base->chunk_list_base[simulthread_context_base->thread_idx];
+  item_idx=item_idx_min;
+  do{
+    value=list_base[item_idx];
+    if(inclusive_status){
+      sum+=value;
+      list_base[item_idx]=sum;
+    }else{
+      list_base[item_idx]=sum;
+      sum+=value;
+    }
+  }while((item_idx++)!=item_idx_max);
+  return;
+}
+
+u8
+spawn_scan(spawn_t *spawn_base,ULONG *list_base,ULONG idx_max,u8 inclusive_status){
+/*
+Replace a list of (ULONG)s with its prefix sums in parallel, in 2 passes: one to sum each chunk, and one to rewrite each chunk, starting from the sum of the chunks before it. Sums wrap modulo (ULONG_MAX+1). Must not be called while any threads are in flight.
+
+In:
+
+  list_base is the base of the list.
+
+  idx_max is the maximum index into list_base.
+
+  inclusive_status is 1 for an inclusive scan, in which item N becomes the sum of items 0 through N, else 0 for an exclusive scan, in which it becomes the sum of items 0 through (N-1), and item 0 becomes 0.
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(). Its function_base, readonly_string_base, and instrumentation are unaffected.
+
+Out:
+
+  Returns 1 on failure, in which case the list is undefined, else 0.
+*/
+  spawn_chunk_t chunk;
+  ULONG chunk_idx;
+  ULONG chunk_idx_max;
+  ULONG *chunk_list_base;
+  ULONG sum;
+  ULONG sum_chunk;
+  u8 status;
+
+  status=1;
+  chunk.base=(u8 *)(list_base);
+  chunk.inclusive_status=inclusive_status;
+  chunk.item_idx_max=idx_max;
+  chunk.item_size=sizeof(ULONG);
+  chunk_idx_max=spawn_chunk_count_get(spawn_base,&chunk);
+  chunk_list_base=(ULONG *)(spawn_malloc((ULONG)(((chunk_idx_max+1)*sizeof(ULONG))-1)));
+  if(chunk_list_base){
+    chunk.chunk_list_base=chunk_list_base;
+    status=spawn_chunk_run(spawn_base,spawn_scan_sum_execute,&chunk);
+    if(!status){
+      sum=0;
+      chunk_idx=0;
+      do{
+        sum_chunk=chunk_list_base[chunk_idx];
+        chunk_list_base[chunk_idx]=sum;
+        sum+=sum_chunk;
+      }while((chunk_idx++)!=chunk_idx_max);
+      status=spawn_chunk_run(spawn_base,spawn_scan_execute,&chunk);
+    }
+    spawn_free(chunk_list_base);
+  }
+  return status;
+}
+
+void
+spawn_histogram_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Count the items of one chunk into its private histogram for spawn_histogram(). Do not call from outside Spawn.
+*/
+  ULONG bin_idx;
+  ULONG bin_idx_max;
+  ULONG *bin_list_base;
+  spawn_chunk_t *chunk_base;
+  ULONG item_idx;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+  ULONG *list_base;
+  u8 shift;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  bin_idx_max=chunk_base->bin_idx_max;
+  bin_list_base=&chunk_base->chunk_list_base[simulthread_context_base->thread_idx*(bin_idx_max+1)];
+  list_base=(ULONG *)(chunk_base->source_base);
+  shift=chunk_base->shift;
+  memset(bin_list_base,0,(size_t)(bin_idx_max+1)*sizeof(ULONG));
+  item_idx=item_idx_min;
+  do{
+    bin_idx=MIN(list_base[item_idx]>>shift,bin_idx_max);
+    bin_list_base[bin_idx]++;
+  }while((item_idx++)!=item_idx_max);
+  return;
+}
+
+void
+spawn_histogram_reduce_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Sum one chunk of bins across all private histograms for spawn_histogram(). Do not call from outside Spawn.
+*/
+  ULONG bin_count;
+  ULONG bin_idx;
+  ULONG bin_idx_max;
+  ULONG bin_idx_min;
+  ULONG *bin_list_base;
+  spawn_chunk_t *chunk_base;
+  ULONG chunk_idx;
+  ULONG *chunk_list_base;
+  ULONG sum;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&bin_idx_min,&bin_idx_max);
+  bin_count=chunk_base->bin_idx_max+1;
+  bin_list_base=(ULONG *)(chunk_base->base);
+  chunk_list_base=chunk_base->chunk_list_base;
+  bin_idx=bin_idx_min;
+  do{
+    sum=0;
+    chunk_idx=0;
+    do{
+      sum+=chunk_list_base[(chunk_idx*bin_count)+bin_idx];
+    }while((chunk_idx++)!=chunk_base->list_chunk_idx_max);
+    bin_list_base[bin_idx]=sum;
+  }while((bin_idx++)!=bin_idx_max);
+  return;
+}
+
+u8
+spawn_histogram(spawn_t *spawn_base,ULONG *list_base,ULONG idx_max,ULONG *bin_list_base,ULONG bin_idx_max,u8 shift){
+/*
+Count the items of a list of (ULONG)s into bins in parallel. Each simulthread fills a private histogram for its chunk of the list, so there are no atomic operations, then the histograms are summed in parallel, by chunks of bins. Must not be called while any threads are in flight.
+
+In:
+
+  list_base is the base of the list.
+
+  idx_max is the maximum index into list_base.
+
+  bin_list_base is the base of (bin_idx_max+1) (ULONG)s, which need not be initialized.
+
+  bin_idx_max is the maximum bin index.
+
+  shift is the number of bits by which to shift each item right to get its bin index, at most ULONG_BIT_MAX. Items which would land beyond bin_idx_max are counted in bin_idx_max.
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(). Its function_base, readonly_string_base, and instrumentation are unaffected.
+
+Out:
+
+  Returns 1 on failure, in which case *bin_list_base is undefined, else 0.
+
+  *bin_list_base contains the number of items in each bin.
+*/
+  spawn_chunk_t chunk;
+  u64 chunk_list_size;
+  ULONG *chunk_list_base;
+  u8 status;
+
+  status=1;
+  chunk.source_base=(u8 *)(list_base);
+  chunk.bin_idx_max=bin_idx_max;
+  chunk.item_idx_max=idx_max;
+  chunk.item_size=sizeof(ULONG);
+  chunk.shift=shift;
+  chunk.list_chunk_idx_max=spawn_chunk_count_get(spawn_base,&chunk);
+  chunk_list_size=((u64)(chunk.list_chunk_idx_max)+1)*((u64)(bin_idx_max)+1)*sizeof(ULONG);
+  chunk_list_base=NULL;
+  if((shift<=ULONG_BIT_MAX)&&(chunk_list_size<=ULONG_MAX)&&(bin_idx_max<ULONG_MAX)){
+    chunk_list_base=(ULONG *)(spawn_malloc((ULONG)(chunk_list_size-1)));
+  }
+  if(chunk_list_base){
+    chunk.chunk_list_base=chunk_list_base;
+    status=spawn_chunk_run(spawn_base,spawn_histogram_execute,&chunk);
+    if(!status){
+      chunk.base=(u8 *)(bin_list_base);
+      chunk.item_idx_max=bin_idx_max;
+      status=spawn_chunk_run(spawn_base,spawn_histogram_reduce_execute,&chunk);
+    }
+    spawn_free(chunk_list_base);
+  }
+  return status;
+}
+
+void
+spawn_partition_count_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Count the items of one chunk which satisfy the predicate for spawn_partition(). Do not call from outside Spawn.
+*/
+  spawn_chunk_t *chunk_base;
+  ULONG item_idx;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+  ULONG *list_base;
+  u8 (*predicate_function_base)(ULONG,u8 *);
+  u8 *readonly_string_base;
+  ULONG true_count;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  list_base=(ULONG *)(chunk_base->source_base);
+  predicate_function_base=chunk_base->predicate_function_base;
+  readonly_string_base=chunk_base->readonly_string_base;
+  true_count=0;
+  item_idx=item_idx_min;
+  do{
+    true_count+=!!predicate_function_base(list_base[item_idx],readonly_string_base);
+  }while((item_idx++)!=item_idx_max);
+  chunk_base->chunk_list_base[simulthread_context_base->thread_idx]=true_count;
+  return;
+}
+
+void
+spawn_partition_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Scatter the items of one chunk to their partitioned positions for spawn_partition(). Do not call from outside Spawn.
+*/
+  spawn_chunk_t *chunk_base;
+  ULONG *destination_base;
+  ULONG false_idx;
+  ULONG item_idx;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+  ULONG *list_base;
+  u8 (*predicate_function_base)(ULONG,u8 *);
+  u8 *readonly_string_base;
+  ULONG true_idx;
+  ULONG value;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  destination_base=(ULONG *)(chunk_base->base);
+  list_base=(ULONG *)(chunk_base->source_base);
+  predicate_function_base=chunk_base->predicate_function_base;
+  readonly_string_base=chunk_base->readonly_string_base;
+/*
+Of the item_idx_min items before this chunk, chunk_list_base counts those which satisfy the predicate. The rest go before this chunk's items in the second partition.
+*/
+  true_idx=chunk_base->chunk_list_base[simulthread_context_base->thread_idx];
+  false_idx=chunk_base->partition_count+item_idx_min-true_idx;
+  item_idx=item_idx_min;
+  do{
+    value=list_base[item_idx];
+    if(predicate_function_base(value,readonly_string_base)){
+      destination_base[true_idx]=value;
+      true_idx++;
+    }else{
+      destination_base[false_idx]=value;
+      false_idx++;
+    }
+  }while((item_idx++)!=item_idx_max);
+  return;
+}
+
+u8
+spawn_partition(spawn_t *spawn_base,ULONG *list_base,ULONG idx_max,u8 (*predicate_function_base)(ULONG,u8 *),u8 *readonly_string_base,ULONG *true_count_base){
+/*
+Stably partition a list of (ULONG)s in parallel, so that the items which satisfy a predicate come first, followed by those which don't, each in their original order. Each simulthread counts the matches in its chunk, then scatters its chunk to positions found from the counts of the chunks before it. Must not be called while any threads are in flight.
+
+In:
+
+  list_base is the base of the list.
+
+  idx_max is the maximum index into list_base.
+
+  predicate_function_base is called with an item and readonly_string_base, and returns nonzero if the item belongs in the first partition, else 0. It's called twice per item, from any simulthread, so it must be deterministic.
+
+  readonly_string_base is passed through to predicate_function_base.
+
+  *true_count_base is writable.
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(). Its function_base, readonly_string_base, and instrumentation are unaffected.
+
+Out:
+
+  Returns 1 on failure, in which case the list is unchanged, else 0.
+
+  *true_count_base is, on success, the number of items in the first partition.
+*/
+  spawn_chunk_t chunk;
+  ULONG chunk_idx;
+  ULONG chunk_idx_max;
+  ULONG *chunk_list_base;
+  u64 list_size;
+  ULONG *scratch_base;
+  u8 status;
+  ULONG true_count;
+  ULONG true_count_chunk;
+
+  status=1;
+  chunk.source_base=(u8 *)(list_base);
+  chunk.predicate_function_base=predicate_function_base;
+  chunk.readonly_string_base=readonly_string_base;
+  chunk.item_idx_max=idx_max;
+  chunk.item_size=sizeof(ULONG);
+  chunk_idx_max=spawn_chunk_count_get(spawn_base,&chunk);
+  list_size=((u64)(idx_max)+1)*sizeof(ULONG);
+  chunk_list_base=(ULONG *)(spawn_malloc((ULONG)(((chunk_idx_max+1)*sizeof(ULONG))-1)));
+  scratch_base=NULL;
+  if(list_size<=ULONG_MAX){
+    scratch_base=(ULONG *)(spawn_malloc((ULONG)(list_size-1)));
+  }
+  if(chunk_list_base&&scratch_base){
+    chunk.base=(u8 *)(scratch_base);
+    chunk.chunk_list_base=chunk_list_base;
+    status=spawn_chunk_run(spawn_base,spawn_partition_count_execute,&chunk);
+    if(!status){
+      true_count=0;
+      chunk_idx=0;
+      do{
+        true_count_chunk=chunk_list_base[chunk_idx];
+        chunk_list_base[chunk_idx]=true_count;
+        true_count+=true_count_chunk;
+      }while((chunk_idx++)!=chunk_idx_max);
+      chunk.partition_count=true_count;
+      status=spawn_chunk_run(spawn_base,spawn_partition_execute,&chunk);
+      if(!status){
+/*
+The list is untouched until here, and if the parallel copy fails partway, then the complete result is still in the scratch list, so finish serially.
+*/
+        if(spawn_copy(spawn_base,(u8 *)(list_base),(u8 *)(scratch_base),(ULONG)(list_size))){
+          memcpy(list_base,scratch_base,(size_t)(list_size));
+        }
+        *true_count_base=true_count;
+      }
+    }
+  }
+  spawn_free(scratch_base);
+  spawn_free(chunk_list_base);
+  return status;
+}
+
+int
+spawn_top_compare(const void *idx_base0,const void *idx_base1){
+/*
+Compare 2 (ULONG)s for qsort() into descending order. Do not call from outside Spawn.
+*/
+  return spawn_bulk_compare(idx_base1,idx_base0);
+}
+
+void
+spawn_top_heap_sift(ULONG *heap_base,ULONG heap_idx_max,ULONG heap_idx){
+/*
+Restore the min-heap property below an entry whose value may have increased. Do not call from outside Spawn.
+
+In:
+
+  heap_base is the base of a min-heap with (heap_idx_max+1) entries, which is valid except possibly at heap_idx.
+
+  heap_idx is the index of the entry to move down.
+
+Out:
+
+  *heap_base is a valid min-heap.
+*/
+  ULONG child_idx;
+  ULONG value;
+
+  value=heap_base[heap_idx];
+  while(heap_idx_max&&(heap_idx<=((heap_idx_max-1)>>1))){
+    child_idx=(heap_idx<<1)+1;
+    if((child_idx<heap_idx_max)&&(heap_base[child_idx+1]<heap_base[child_idx])){
+      child_idx++;
+    }
+    if(value<=heap_base[child_idx]){
+      break;
+    }
+    heap_base[heap_idx]=heap_base[child_idx];
+    heap_idx=child_idx;
+  }
+  heap_base[heap_idx]=value;
+  return;
+}
+
+void
+spawn_top_select(ULONG *heap_base,ULONG *heap_count_base,ULONG heap_idx_max,ULONG *list_base,ULONG idx_max){
+/*
+Feed a list into a min-heap which retains the largest values seen. Do not call from outside Spawn.
+
+In:
+
+  heap_base is the base of space for (heap_idx_max+1) (ULONG)s, of which the first *heap_count_base are in use. It's only a valid min-heap once it's full.
+
+  heap_idx_max is the maximum heap index.
+
+  list_base is the base of (idx_max+1) values to feed.
+
+Out:
+
+  *heap_base contains the largest (heap_idx_max+1) values fed so far, or all of them if fewer, and *heap_count_base is updated.
+*/
+  ULONG heap_count;
+  ULONG heap_idx;
+  ULONG idx;
+  ULONG value;
+
+  heap_count=*heap_count_base;
+  idx=0;
+  do{
+    value=list_base[idx];
+    if(heap_count<=heap_idx_max){
+      heap_base[heap_count]=value;
+      heap_count++;
+      if(heap_count==(heap_idx_max+1)){
+        heap_idx=(heap_idx_max>>1)+1;
+        do{
+          heap_idx--;
+          spawn_top_heap_sift(heap_base,heap_idx_max,heap_idx);
+        }while(heap_idx);
+      }
+    }else if(heap_base[0]<value){
+      heap_base[0]=value;
+      spawn_top_heap_sift(heap_base,heap_idx_max,0);
+    }
+  }while((idx++)!=idx_max);
+  *heap_count_base=heap_count;
+  return;
+}
+
+void
+spawn_top_execute(spawn_simulthread_context_t *simulthread_context_base){
+/*
+Find the largest items of one chunk for spawn_top(). Do not call from outside Spawn.
+*/
+  spawn_chunk_t *chunk_base;
+  ULONG *heap_base;
+  ULONG item_idx_max;
+  ULONG item_idx_min;
+  ULONG top_idx_max;
+
+  chunk_base=(spawn_chunk_t *)(simulthread_context_base->readonly_string_base);
+  spawn_chunk_range_get(simulthread_context_base,&item_idx_min,&item_idx_max);
+  top_idx_max=chunk_base->top_idx_max;
+/*
+Each chunk has a count followed by room for (top_idx_max+1) candidates.
+*/
+  heap_base=&chunk_base->chunk_list_base[simulthread_context_base->thread_idx*(top_idx_max+2)];
+  heap_base[0]=0;
+  spawn_top_select(&heap_base[1],&heap_base[0],top_idx_max,&((ULONG *)(chunk_base->source_base))[item_idx_min],item_idx_max-item_idx_min);
+  return;
+}
+
+u8
+spawn_top(spawn_t *spawn_base,ULONG *list_base,ULONG idx_max,ULONG *top_list_base,ULONG top_idx_max){
+/*
+Find the largest items of a list of (ULONG)s in parallel. Each simulthread keeps the largest items of its chunk in a min-heap, then the master merges the candidates of all chunks. Must not be called while any threads are in flight.
+
+In:
+
+  list_base is the base of the list, which is unchanged.
+
+  idx_max is the maximum index into list_base.
+
+  top_list_base is the base of (top_idx_max+1) (ULONG)s, which need not be initialized.
+
+  top_idx_max is one less than the number of items to find, at most idx_max.
+
+  *spawn_base is as returned by spawn_multi_init() or spawn_mono_init(). Its function_base, readonly_string_base, and instrumentation are unaffected.
+
+Out:
+
+  Returns 1 on failure, in which case *top_list_base is undefined, else 0.
+
+  *top_list_base contains the largest (top_idx_max+1) items, in descending order, with duplicates retained.
+*/
+  spawn_chunk_t chunk;
+  ULONG chunk_idx;
+  ULONG chunk_idx_max;
+  ULONG *chunk_list_base;
+  u64 chunk_list_size;
+  ULONG *heap_base;
+  ULONG heap_count;
+  u8 status;
+
+  status=1;
+  chunk.source_base=(u8 *)(list_base);
+  chunk.item_idx_max=idx_max;
+  chunk.item_size=sizeof(ULONG);
+  chunk.top_idx_max=top_idx_max;
+  chunk_idx_max=spawn_chunk_count_get(spawn_base,&chunk);
+  chunk_list_size=((u64)(chunk_idx_max)+1)*((u64)(top_idx_max)+2)*sizeof(ULONG);
+  chunk_list_base=NULL;
+  if((top_idx_max<=idx_max)&&(chunk_list_size<=ULONG_MAX)){
+    chunk_list_base=(ULONG *)(spawn_malloc((ULONG)(chunk_list_size-1)));
+  }
+  if(chunk_list_base){
+    chunk.chunk_list_base=chunk_list_base;
+    status=spawn_chunk_run(spawn_base,spawn_top_execute,&chunk);
+    if(!status){
+      heap_count=0;
+      chunk_idx=0;
+      do{
+        heap_base=&chunk_list_base[chunk_idx*(top_idx_max+2)];
+        if(heap_base[0]){
+          spawn_top_select(top_list_base,&heap_count,top_idx_max,&heap_base[1],heap_base[0]-1);
+        }
+      }while((chunk_idx++)!=chunk_idx_max);
+      qsort(top_list_base,(size_t)(top_idx_max)+1,sizeof(ULONG),spawn_top_compare);
+    }
+    spawn_free(chunk_list_base);
+  }
+  return status;
+}
@@ -20,40 +20,419 @@ You should have received a copy of the GNU Limited General Public
 License version 3 along with the Spawn Library (filename
 "COPYING"). If not, see http://www.gnu.org/licenses/ .
 */
+#define SPAWN_BACKOFF_SPIN_COUNT 64U
+#define SPAWN_BUDGET_HEADROOM_SHIFT 3U
+#define SPAWN_BULK_CHUNK_COUNT_LOG2 2U
+#define SPAWN_IO_QUEUE_SIZE_LOG2_MAX 12U
+#define SPAWN_LOCALITY_CACHE_IDX_MAX 7U
+#define SPAWN_LOG_DRAIN_NANOSECONDS 1000000U
+#define SPAWN_LOG_RING_SIZE_LOG2_MIN 8U
+#define SPAWN_LOG_TEXT_SIZE_MAX 255U
+#define SPAWN_PERF_BRANCH_MISS_IDX 0U
+#define SPAWN_PERF_CONTEXT_SWITCH_IDX 1U
+#define SPAWN_PERF_CYCLE_IDX 2U
+#define SPAWN_PERF_IDX_MAX 4U
+#define SPAWN_PERF_INSTRUCTION_IDX 3U
+#define SPAWN_PERF_LLC_MISS_IDX 4U
+#define SPAWN_PROFILE_TASK_IDX_MAX_MIN 1023U
+#define SPAWN_SPECULATE_COMMITTED 1U
+#define SPAWN_SPECULATE_DUPLICATED 2U
+#define SPAWN_STAT_SIGNATURE 0x5441545354574153ULL
+#define SPAWN_STAT_WINDOW_NANOSECONDS 1000000000ULL
+#define SPAWN_STOP_DEADLINE 2U
+#define SPAWN_STOP_SET 1U
+
 TYPEDEF_START
   u8 *readonly_string_base;
   ULONG thread_idx;
   u32 simulthread_idx;
 TYPEDEF_END(spawn_simulthread_context_t)
 
+TYPEDEF_START
+  u8 *base;
+  ULONG *chunk_list_base;
+  void (*generate_function_base)(u8 *,ULONG,u8 *);
+  u8 *item_base;
+  u8 (*predicate_function_base)(ULONG,u8 *);
+  u8 *readonly_string_base;
+  u8 *source_base;
+  ULONG bin_idx_max;
+  ULONG chunk_item_count;
+  ULONG item_idx_max;
+  ULONG item_size;
+  ULONG list_chunk_idx_max;
+  ULONG list_idx_max;
+  ULONG partition_count;
+  ULONG run_item_count;
+  ULONG top_idx_max;
+  u8 inclusive_status;
+  u8 shift;
+TYPEDEF_END(spawn_chunk_t)
+
+TYPEDEF_START
+  u8 *item_base;
+  void *pipe_base;
+  u8 *readonly_string_base;
+  u32 stage_idx;
+  u32 worker_idx;
+TYPEDEF_END(spawn_pipe_context_t)
+
+/*
+Structures which contain pthread objects or atomically accessed variables aren't packed, because those must be naturally aligned.
+*/
+typedef struct{
+  u8 *item_base;
+  u64 sequence __attribute__ ((aligned(8)));
+}spawn_pipe_cell_t;
+
+typedef struct{
+  void (*function_base)(spawn_pipe_context_t *);
+  spawn_pipe_cell_t *cell_list_base;
+  spawn_pipe_context_t *pipe_context_list_base;
+#ifdef PTHREAD
+  pthread_t *pthread_list_base;
+#endif
+  u64 cell_idx_max;
+  u64 pop_idx;
+  u64 push_idx;
+  u32 worker_idx_max;
+  u32 worker_launch_count;
+  u8 upstream_done_status;
+}spawn_pipe_stage_t;
+
+TYPEDEF_START
+  u8 *readonly_string_base;
+  spawn_pipe_stage_t *stage_list_base;
+  u32 stage_idx_max;
+TYPEDEF_END(spawn_pipe_t)
+
+TYPEDEF_START
+  u64 count_list[SPAWN_PERF_IDX_MAX+1];
+  u64 task_count;
+TYPEDEF_END(spawn_perf_t)
+
+TYPEDEF_START
+  spawn_perf_t *range_perf_list_base;
+  spawn_perf_t *simulthread_perf_list_base;
+  ULONG range_idx_max;
+  u8 available_mask;
+  u8 kernel_exclude_mask;
+  u8 range_size_log2;
+TYPEDEF_END(spawn_perf_state_t)
+
+typedef struct{
+#ifdef PTHREAD
+  pthread_cond_t cond;
+  pthread_mutex_t mutex;
+#endif
+  u8 *attempt_list_base;
+  u8 *result_list_base;
+  u8 *state_list_base;
+  u64 straggler_nanoseconds;
+  ULONG result_size;
+  ULONG thread_idx_max;
+  u32 simulthread_active_count;
+}spawn_speculate_state_t;
+
+TYPEDEF_START
+  u64 duration_nanoseconds;
+  u64 gap_nanoseconds;
+  ULONG thread_idx;
+TYPEDEF_END(spawn_profile_task_t)
+
+TYPEDEF_START
+  spawn_profile_task_t *task_list_base;
+  u64 end_nanoseconds;
+  ULONG task_count;
+  ULONG task_idx_max;
+  u8 overflow_status;
+TYPEDEF_END(spawn_profile_state_t)
+
+TYPEDEF_START
+  u64 amdahl_milli;
+  u64 busy_nanoseconds;
+  u64 makespan_nanoseconds;
+  u64 serial_nanoseconds;
+  u64 speedup_milli;
+  u64 utilisation_milli;
+  ULONG task_count;
+TYPEDEF_END(spawn_profile_prediction_t)
+
+typedef struct{
+  u8 *cache_list_base;
+  void (*depend_function_base)(spawn_simulthread_context_t *);
+  u64 *fingerprint_list_base;
+  u8 *result_list_base;
+  u8 *valid_list_base;
+  u64 hit_count;
+  u64 miss_count;
+  ULONG result_size;
+  ULONG thread_idx_max;
+}spawn_memo_state_t;
+
+TYPEDEF_START
+  u8 *base;
+  ULONG size;
+  ULONG size_max;
+  u8 done_status;
+TYPEDEF_END(spawn_sink_buffer_t)
+
+typedef struct{
+#ifdef PTHREAD
+  pthread_cond_t producer_cond;
+  pthread_cond_t writer_cond;
+  pthread_mutex_t mutex;
+  pthread_t writer_pthread;
+#endif
+  spawn_sink_buffer_t *buffer_list_base;
+  struct iovec *iovec_list_base;
+  ULONG iovec_idx_max;
+  ULONG thread_idx_max;
+  ULONG window_idx_max;
+  ULONG write_idx;
+  int fd;
+  u8 close_status;
+  u8 error_status;
+}spawn_sink_state_t;
+
+/*
+The header of each record written by spawn_log_close() or its drainer when text_status was 0 in spawn_log_open(). It's followed by size bytes of payload.
+*/
+TYPEDEF_START
+  u64 nanoseconds;
+  u64 thread_idx;
+  u32 simulthread_idx;
+  u32 size;
+TYPEDEF_END(spawn_log_record_t)
+
+/*
+A log ring is written only by its simulthread and read only by the drainer. It's padded to 64 bytes regardless of pointer size, with head and tail first, so that those of different simulthreads don't share a cache line.
+*/
+typedef struct{
+  u64 head;
+  u64 tail;
+  u8 *base;
+  u8 padding[64-(sizeof(u64)<<1)-sizeof(u8 *)];
+}spawn_log_ring_t;
+
+typedef struct{
+#ifdef PTHREAD
+  pthread_t drainer_pthread;
+#endif
+  spawn_log_ring_t *ring_list_base;
+  u8 *stage_base;
+  ULONG ring_size;
+  ULONG stage_idx;
+  ULONG stage_size;
+  u32 ring_idx_max;
+  int fd;
+  u8 close_status;
+  u8 error_status;
+  u8 text_status;
+}spawn_log_state_t;
+
+TYPEDEF_START
+  u64 tag;
+  i32 result;
+TYPEDEF_END(spawn_io_completion_t)
+
+/*
+The io_uring ring of one simulthread. The submission and completion queues are declared (void *) so that this header doesn't depend on <linux/io_uring.h>. fd is -1 if io_uring isn't available, in which case operations run synchronously.
+*/
+TYPEDEF_START
+  spawn_io_completion_t *completion_list_base;
+  u32 *cq_head_base;
+  void *cq_map_base;
+  u32 *cq_tail_base;
+  void *cqe_list_base;
+  u32 *sq_array_base;
+  void *sq_map_base;
+  u32 *sq_tail_base;
+  void *sqe_list_base;
+  ULONG cq_map_size;
+  ULONG sq_map_size;
+  ULONG sqe_list_size;
+  u32 completion_count;
+  u32 cq_mask;
+  u32 entry_count;
+  u32 outstanding_count;
+  u32 pending_count;
+  u32 sq_mask;
+  int fd;
+  u8 fixed_status;
+TYPEDEF_END(spawn_io_ring_t)
+
+#ifdef PTHREAD
+  typedef struct{
+    u32 *cpu_count_list_base;
+    cpu_set_t *cpu_set_list_base;
+    u32 *flight_count_list_base;
+    u32 domain_idx_max;
+    u8 domain_status;
+  }spawn_locality_state_t;
+#endif
+
+#ifdef PTHREAD
+  typedef struct{
+    pthread_cond_t cond;
+    pthread_mutex_t mutex;
+    u64 (*estimate_function_base)(spawn_simulthread_context_t *);
+    u64 budget_size;
+    u64 ticket_idx;
+    u64 turn_idx;
+    u64 used_size;
+  }spawn_budget_state_t;
+#endif
+
+#ifdef PTHREAD
+  TYPEDEF_START
+    void *spawn_base;
+    u32 flight_count;
+    u32 share_max;
+    u32 share_min;
+    u32 waiting_count;
+    u32 weight;
+  TYPEDEF_END(spawn_share_job_t)
+
+  typedef struct{
+    pthread_cond_t cond;
+    pthread_mutex_t mutex;
+    spawn_share_job_t *job_list_base;
+    u32 job_idx_max;
+    u32 slot_free_count;
+  }spawn_share_t;
+#endif
+
+/*
+The header of a statistics file, as created by spawn_stat_enable(). It's followed by (simulthread_idx_max+1) (u64)s, each of which is the total nanoseconds spent by a simulthread running thread indexes. All of it is updated atomically while threads are running, and may be read at any time by another process which has mapped the same file, such as spawn_stat.c.
+*/
+typedef struct{
+  u64 complete_count;
+  u64 eta_milliseconds;
+  u64 launch_count;
+  u64 rate_milli;
+  u64 signature;
+  u64 start_nanoseconds;
+  u64 thread_count;
+  u64 update_nanoseconds;
+  u64 window_complete_count;
+  u64 window_nanoseconds;
+  u32 pid;
+  u32 simulthread_idx_max;
+}spawn_stat_t;
+
 TYPEDEF_START
   spawn_simulthread_context_t context;
+  void *spawn_base;
 #ifdef PTHREAD
+  u8 *stack_base;
   pthread_t pthread;
 #endif
+  u64 launch_nanoseconds;
+  u64 memo_fingerprint;
+  int perf_fd_list[SPAWN_PERF_IDX_MAX+1];
+  int perf_group_fd;
+#ifdef PTHREAD
+  u32 locality_domain_idx;
+#endif
+  u8 active_status;
+  u8 done_status;
+#ifdef PTHREAD
+  u8 locality_status;
+#endif
+  u8 sink_status;
 TYPEDEF_END(spawn_simulthread_t)
 
 TYPEDEF_START
+#ifdef PTHREAD
+  spawn_budget_state_t *budget_state_base;
+#endif
+  ULONG *bulk_bitmap_base;
+  ULONG *bulk_idx_list_base;
+  ULONG *done_bitmap_base;
   void (*function_base)(spawn_simulthread_context_t *);
+  spawn_io_ring_t *io_ring_list_base;
+#ifdef PTHREAD
+  spawn_locality_state_t *locality_state_base;
+#endif
+  spawn_log_state_t *log_state_base;
+  spawn_memo_state_t *memo_state_base;
+  spawn_perf_state_t *perf_state_base;
+  void (*prefetch_function_base)(spawn_simulthread_context_t *,ULONG);
+#ifndef PTHREAD
+  spawn_profile_state_t *profile_state_base;
+#else
+  spawn_share_t *share_base;
+#endif
   spawn_simulthread_t *simulthread_list_base;
+  spawn_sink_state_t *sink_state_base;
+  spawn_speculate_state_t *speculate_state_base;
+  spawn_stat_t *stat_base;
+  u64 deadline_nanoseconds;
+  ULONG bulk_chunk_item_count;
+  ULONG bulk_item_idx_max;
+#ifdef PTHREAD
+  ULONG stack_guard_size;
+  ULONG stack_size;
+#endif
+  ULONG stat_size;
+  u32 prefetch_count;
+#ifdef PTHREAD
+  u32 share_job_idx;
+#endif
   u32 simulthread_idx_max;
   u32 simulthread_launch_idx;
+  u32 simulthread_limit_idx_max;
   u32 simulthread_retire_idx;
+  u8 deadline_wrap_status;
   u8 simulthread_active_status;
+  u8 stop_status;
 TYPEDEF_END(spawn_t)
 
 #ifdef PTHREAD
   #define SPAWN(spawn_base,thread_idx_max) spawn_multi(spawn_base,thread_idx_max)
+  #define SPAWN_BITMAP(spawn_base,bitmap_base,bit_idx_max) spawn_multi_bitmap(spawn_base,bitmap_base,bit_idx_max)
+  #define SPAWN_BUDGET_SET(spawn_base,estimate_function_base,budget_size) spawn_multi_budget_set(spawn_base,estimate_function_base,budget_size)
+  #define SPAWN_DEADLINE(spawn_base,thread_idx_max,deadline_nanoseconds,wrap_status,done_bitmap_base) spawn_multi_deadline(spawn_base,thread_idx_max,deadline_nanoseconds,wrap_status,done_bitmap_base)
   #define SPAWN_FREE(spawn_base) spawn_multi_free(spawn_base)
   #define SPAWN_INIT(function_base,readonly_string_base,simulthread_idx_max) spawn_multi_init(function_base,readonly_string_base,simulthread_idx_max)
+  #define SPAWN_LIST(spawn_base,idx_list_base,idx_idx_max,sort_status) spawn_multi_list(spawn_base,idx_list_base,idx_idx_max,sort_status)
+  #define SPAWN_LOCALITY_ENABLE(spawn_base) spawn_multi_locality_enable(spawn_base)
   #define SPAWN_ONE(spawn_base,unique_idx) spawn_multi_one(spawn_base,unique_idx)
+  #define SPAWN_ONE_KEYED(spawn_base,unique_idx,locality_key) spawn_multi_one_keyed(spawn_base,unique_idx,locality_key)
+  #define SPAWN_PIPE_FEED(pipe_base,item_base) spawn_multi_pipe_feed(pipe_base,item_base)
+  #define SPAWN_PIPE_FREE(pipe_base) spawn_multi_pipe_free(pipe_base)
+  #define SPAWN_PIPE_INIT(function_list_base,readonly_string_base,stage_idx_max,worker_idx_max_list_base,queue_size_log2) spawn_multi_pipe_init(function_list_base,readonly_string_base,stage_idx_max,worker_idx_max_list_base,queue_size_log2)
+  #define SPAWN_PIPE_PUSH(pipe_context_base,item_base) spawn_multi_pipe_push(pipe_context_base,item_base)
+  #define SPAWN_PIPE_RETIRE_ALL(pipe_base) spawn_multi_pipe_retire_all(pipe_base)
+  #define SPAWN_PROFILE_ENABLE(spawn_base) 0
+  #define SPAWN_PROFILE_PRINT(spawn_base,file_base,simulthread_idx_max,launch_nanoseconds) 0
+  #define SPAWN_PROFILE_RESET(spawn_base)
   #define SPAWN_RETIRE_ALL(spawn_base) spawn_multi_retire_all(spawn_base)
   #define SPAWN_REWIND(function_base,readonly_string_base,spawn_base) spawn_multi_rewind(function_base,readonly_string_base,spawn_base)
+  #define SPAWN_SIMULTHREAD_LIMIT_SET(spawn_base,simulthread_limit_idx_max) spawn_multi_simulthread_limit_set(spawn_base,simulthread_limit_idx_max)
+  #define SPAWN_STACK_SET(spawn_base,stack_size,guard_size,pool_status) spawn_multi_stack_set(spawn_base,stack_size,guard_size,pool_status)
 #else
   #define SPAWN(spawn_base,thread_idx_max) spawn_mono(spawn_base,thread_idx_max)
+  #define SPAWN_BITMAP(spawn_base,bitmap_base,bit_idx_max) spawn_mono_bitmap(spawn_base,bitmap_base,bit_idx_max)
+  #define SPAWN_BUDGET_SET(spawn_base,estimate_function_base,budget_size) 0
+  #define SPAWN_DEADLINE(spawn_base,thread_idx_max,deadline_nanoseconds,wrap_status,done_bitmap_base) spawn_mono_deadline(spawn_base,thread_idx_max,deadline_nanoseconds,wrap_status,done_bitmap_base)
   #define SPAWN_FREE(spawn_base) spawn_mono_free(spawn_base)
   #define SPAWN_INIT(function_base,readonly_string_base,simulthread_idx_max) spawn_mono_init(function_base,readonly_string_base)
+  #define SPAWN_LIST(spawn_base,idx_list_base,idx_idx_max,sort_status) spawn_mono_list(spawn_base,idx_list_base,idx_idx_max,sort_status)
+  #define SPAWN_LOCALITY_ENABLE(spawn_base) 0
   #define SPAWN_ONE(spawn_base,unique_idx) spawn_mono_one(spawn_base,unique_idx)
+  #define SPAWN_ONE_KEYED(spawn_base,unique_idx,locality_key) spawn_mono_one(spawn_base,unique_idx)
+  #define SPAWN_PIPE_FEED(pipe_base,item_base) spawn_mono_pipe_feed(pipe_base,item_base)
+  #define SPAWN_PIPE_FREE(pipe_base) spawn_mono_pipe_free(pipe_base)
+  #define SPAWN_PIPE_INIT(function_list_base,readonly_string_base,stage_idx_max,worker_idx_max_list_base,queue_size_log2) spawn_mono_pipe_init(function_list_base,readonly_string_base,stage_idx_max)
+  #define SPAWN_PIPE_PUSH(pipe_context_base,item_base) spawn_mono_pipe_push(pipe_context_base,item_base)
+  #define SPAWN_PIPE_RETIRE_ALL(pipe_base)
+  #define SPAWN_PROFILE_ENABLE(spawn_base) spawn_mono_profile_enable(spawn_base)
+  #define SPAWN_PROFILE_PRINT(spawn_base,file_base,simulthread_idx_max,launch_nanoseconds) spawn_mono_profile_print(spawn_base,file_base,simulthread_idx_max,launch_nanoseconds)
+  #define SPAWN_PROFILE_RESET(spawn_base) spawn_mono_profile_reset(spawn_base)
   #define SPAWN_RETIRE_ALL(spawn_base)
   #define SPAWN_REWIND(function_base,readonly_string_base,spawn_base) spawn_mono_rewind(function_base,readonly_string_base,spawn_base)
+  #define SPAWN_SIMULTHREAD_LIMIT_SET(spawn_base,simulthread_limit_idx_max)
+  #define SPAWN_STACK_SET(spawn_base,stack_size,guard_size,pool_status) 0
 #endif
@@ -0,0 +1,153 @@
+/*
+Spawn Library
+Copyright 2016 Russell Leidich
+http://spawnthread.blogspot.com
+
+This collection of files constitutes the Spawn Library. (This is a
+library in the abstact sense; it's not intended to compile to a ".lib"
+file.)
+
+The Spawn Library is free software: you can redistribute it and/or
+modify it under the terms of the GNU Limited General Public License as
+published by the Free Software Foundation, version 3.
+
+The Spawn Library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Limited General Public License version 3 for more details.
+
+You should have received a copy of the GNU Limited General Public
+License version 3 along with the Spawn Library (filename
+"COPYING"). If not, see http://www.gnu.org/licenses/ .
+*/
+/*
+Spawn Statistics Reader
+
+Print the live progress and throughput of a running Spawn job, as published by spawn_stat_enable(), without pausing or signalling it. Build it with the same switches as the job, so that the layout of spawn_stat_t matches.
+
+Usage: spawn_stat path [interval_seconds]
+
+With an interval, print a line every interval_seconds until interrupted, else print one line and exit. A growing "idle" time while threads are in flight means that the job has stalled.
+*/
+#include "flag.h"
+#include "unix_include.h"
+#include "constant.h"
+#include "spawn.h"
+
+u64
+stat_nanosecond_get(void){
+/*
+Read the monotonic clock, which is the one used by Spawn for its timestamps.
+
+In:
+
+  (None.)
+
+Out:
+
+  Returns the time in nanoseconds since an arbitrary epoch.
+*/
+  struct timespec timespec;
+
+  clock_gettime(CLOCK_MONOTONIC,&timespec);
+  return ((u64)(timespec.tv_sec)*1000000000ULL)+(u64)(timespec.tv_nsec);
+}
+
+void
+stat_print(spawn_stat_t *stat_base){
+/*
+Print one snapshot of a statistics file.
+
+In:
+
+  *stat_base is the mapped file.
+
+Out:
+
+  A line has been printed to stdout.
+*/
+  u64 busy_nanoseconds;
+  u64 *busy_list_base;
+  u64 complete_count;
+  u64 elapsed_nanoseconds;
+  u64 eta_milliseconds;
+  u64 launch_count;
+  u64 nanoseconds;
+  u64 rate_milli;
+  u32 simulthread_idx;
+  u64 thread_count;
+  u64 update_nanoseconds;
+
+  busy_list_base=(u64 *)(&stat_base[1]);
+/*
+Read completions before launches, so that the number in flight can't appear negative.
+*/
+  complete_count=__atomic_load_n(&stat_base->complete_count,__ATOMIC_RELAXED);
+  launch_count=__atomic_load_n(&stat_base->launch_count,__ATOMIC_RELAXED);
+  thread_count=__atomic_load_n(&stat_base->thread_count,__ATOMIC_RELAXED);
+  rate_milli=__atomic_load_n(&stat_base->rate_milli,__ATOMIC_RELAXED);
+  eta_milliseconds=__atomic_load_n(&stat_base->eta_milliseconds,__ATOMIC_RELAXED);
+  update_nanoseconds=__atomic_load_n(&stat_base->update_nanoseconds,__ATOMIC_RELAXED);
+  nanoseconds=stat_nanosecond_get();
+  elapsed_nanoseconds=nanoseconds-stat_base->start_nanoseconds;
+  printf("pid %u: launched %llu, complete %llu/%llu, in flight %llu, %llu.%03llu/s",stat_base->pid,(unsigned long long)(launch_count),(unsigned long long)(complete_count),(unsigned long long)(thread_count),(unsigned long long)(launch_count-complete_count),(unsigned long long)(rate_milli/1000),(unsigned long long)(rate_milli%1000));
+  if(eta_milliseconds!=U64_MAX){
+    printf(", ETA %llu s",(unsigned long long)(eta_milliseconds/1000));
+  }
+  printf(", idle %llu ms, busy %%:",(unsigned long long)((nanoseconds-MIN(nanoseconds,update_nanoseconds))/1000000));
+  simulthread_idx=0;
+  do{
+    busy_nanoseconds=__atomic_load_n(&busy_list_base[simulthread_idx],__ATOMIC_RELAXED);
+    printf(" %llu",(unsigned long long)((busy_nanoseconds*100)/MAX(elapsed_nanoseconds,1)));
+  }while((simulthread_idx++)!=stat_base->simulthread_idx_max);
+  printf("\n");
+  fflush(stdout);
+  return;
+}
+
+int
+main(int argc, char *argv[]){
+  int fd;
+  unsigned int interval_seconds;
+  void *map_base;
+  struct stat file_stat;
+  spawn_stat_t *stat_base;
+
+  if((argc!=2)&&(argc!=3)){
+    printf("Usage: spawn_stat path [interval_seconds]\n");
+    exit(1);
+  }
+  interval_seconds=0;
+  if(argc==3){
+    interval_seconds=(unsigned int)(strtoul(argv[2],NULL,10));
+  }
+  fd=open(argv[1],O_RDONLY);
+  if(fd<0){
+    printf("Can't open %s\n",argv[1]);
+    exit(1);
+  }
+  if(fstat(fd,&file_stat)||((u64)(file_stat.st_size)<sizeof(spawn_stat_t))){
+    printf("Not a statistics file: %s\n",argv[1]);
+    exit(1);
+  }
+  map_base=mmap(NULL,(size_t)(file_stat.st_size),PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if(map_base==MAP_FAILED){
+    printf("Can't map %s\n",argv[1]);
+    exit(1);
+  }
+  stat_base=(spawn_stat_t *)(map_base);
+  if((__atomic_load_n(&stat_base->signature,__ATOMIC_ACQUIRE)!=SPAWN_STAT_SIGNATURE)||((u64)(file_stat.st_size)<(sizeof(spawn_stat_t)+(((u64)(stat_base->simulthread_idx_max)+1)*sizeof(u64))))){
+    printf("Not a statistics file: %s\n",argv[1]);
+    exit(1);
+  }
+  do{
+    stat_print(stat_base);
+    if(!interval_seconds){
+      break;
+    }
+    sleep(interval_seconds);
+  }while(1);
+  munmap(map_base,(size_t)(file_stat.st_size));
+  return 0;
+}
@@ -20,16 +20,91 @@ You should have received a copy of the GNU Limited General Public
 License version 3 along with the Spawn Library (filename
 "COPYING"). If not, see http://www.gnu.org/licenses/ .
 */
+extern u8 spawn_copy(spawn_t *spawn_base,u8 *destination_base,u8 *source_base,ULONG size);
+extern u8 spawn_fill(spawn_t *spawn_base,u8 *base,ULONG item_idx_max,u8 *item_base,ULONG item_size);
+extern u8 spawn_generate(spawn_t *spawn_base,u8 *base,ULONG item_idx_max,ULONG item_size,void (*generate_function_base)(u8 *,ULONG,u8 *),u8 *readonly_string_base);
+extern u8 spawn_histogram(spawn_t *spawn_base,ULONG *list_base,ULONG idx_max,ULONG *bin_list_base,ULONG bin_idx_max,u8 shift);
+extern u8 spawn_io_enable(spawn_t *spawn_base,u8 queue_size_log2,struct iovec *iovec_list_base,u32 iovec_idx_max);
+extern void spawn_io_free(spawn_t *spawn_base);
+extern u8 spawn_io_read(spawn_simulthread_context_t *simulthread_context_base,int fd,u8 *base,ULONG size,u64 offset,u64 tag);
+extern u8 spawn_io_read_fixed(spawn_simulthread_context_t *simulthread_context_base,int fd,u32 iovec_idx,u8 *base,ULONG size,u64 offset,u64 tag);
+extern u8 spawn_io_submit(spawn_simulthread_context_t *simulthread_context_base);
+extern u8 spawn_io_wait(spawn_simulthread_context_t *simulthread_context_base,u64 tag,i32 *result_base);
+extern u8 spawn_io_write(spawn_simulthread_context_t *simulthread_context_base,int fd,u8 *base,ULONG size,u64 offset,u64 tag);
+extern u8 spawn_io_write_fixed(spawn_simulthread_context_t *simulthread_context_base,int fd,u32 iovec_idx,u8 *base,ULONG size,u64 offset,u64 tag);
+extern u8 spawn_log_close(spawn_t *spawn_base);
+extern u8 spawn_log_open(spawn_t *spawn_base,int fd,u8 ring_size_log2,u8 text_status);
+extern u8 spawn_log_printf(spawn_simulthread_context_t *simulthread_context_base,const char *format_base,...);
+extern u8 spawn_log_write(spawn_simulthread_context_t *simulthread_context_base,u8 *base,ULONG size);
+extern void spawn_memo_count_get(spawn_t *spawn_base,u64 *hit_count_base,u64 *miss_count_base);
+extern void spawn_memo_depend(spawn_simulthread_context_t *simulthread_context_base,u8 *base,ULONG size);
+extern void spawn_memo_depend_hash(spawn_simulthread_context_t *simulthread_context_base,u64 hash);
+extern u8 spawn_memo_enable(spawn_t *spawn_base,void (*depend_function_base)(spawn_simulthread_context_t *),u8 *result_list_base,ULONG result_size,ULONG thread_idx_max);
+extern void spawn_memo_free(spawn_t *spawn_base);
+extern u8 spawn_partition(spawn_t *spawn_base,ULONG *list_base,ULONG idx_max,u8 (*predicate_function_base)(ULONG,u8 *),u8 *readonly_string_base,ULONG *true_count_base);
+extern u8 spawn_perf_available_mask_get(spawn_t *spawn_base);
+extern u8 spawn_perf_enable(spawn_t *spawn_base,ULONG thread_idx_max,u8 range_size_log2);
+extern void spawn_perf_print(spawn_t *spawn_base,FILE *file_base);
+extern spawn_perf_t *spawn_perf_range_get(spawn_t *spawn_base,ULONG range_idx);
+extern void spawn_perf_reset(spawn_t *spawn_base);
+extern void spawn_prefetch_set(spawn_t *spawn_base,void (*prefetch_function_base)(spawn_simulthread_context_t *,ULONG),u32 prefetch_count);
+extern spawn_perf_t *spawn_perf_simulthread_get(spawn_t *spawn_base,u32 simulthread_idx);
+extern u8 spawn_scan(spawn_t *spawn_base,ULONG *list_base,ULONG idx_max,u8 inclusive_status);
+extern u8 spawn_sink_close(spawn_t *spawn_base);
+extern u8 spawn_sink_emit(spawn_simulthread_context_t *simulthread_context_base,u8 *record_base,ULONG record_size);
+extern u8 spawn_sink_open(spawn_t *spawn_base,int fd,ULONG thread_idx_max,ULONG window_idx_max);
+extern u8 *spawn_speculate_attempt_base_get(spawn_simulthread_context_t *simulthread_context_base);
+extern u8 spawn_sort(spawn_t *spawn_base,ULONG *list_base,ULONG idx_max);
+extern u8 spawn_speculate_enable(spawn_t *spawn_base,u8 *result_list_base,ULONG result_size,ULONG thread_idx_max,u64 straggler_nanoseconds);
+extern void spawn_speculate_free(spawn_t *spawn_base);
+extern u8 spawn_speculate_lost_get(spawn_simulthread_context_t *simulthread_context_base);
+extern u8 spawn_stat_enable(spawn_t *spawn_base,char *path_base);
+extern void spawn_stat_free(spawn_t *spawn_base);
+extern void spawn_stat_total_add(spawn_t *spawn_base,u64 thread_count);
+extern u8 spawn_stop_get(spawn_simulthread_context_t *simulthread_context_base);
+extern u8 spawn_stop_set(spawn_simulthread_context_t *simulthread_context_base);
+extern u8 spawn_top(spawn_t *spawn_base,ULONG *list_base,ULONG idx_max,ULONG *top_list_base,ULONG top_idx_max);
 #ifdef PTHREAD
+  extern void spawn_multi_budget_free(spawn_t *spawn_base);
+  extern u8 spawn_multi_budget_set(spawn_t *spawn_base,u64 (*estimate_function_base)(spawn_simulthread_context_t *),u64 budget_size);
+  extern u8 spawn_multi_locality_enable(spawn_t *spawn_base);
+  extern void spawn_multi_locality_free(spawn_t *spawn_base);
   extern u8 spawn_multi_one(spawn_t *spawn_base,ULONG unique_idx);
+  extern u8 spawn_multi_one_keyed(spawn_t *spawn_base,ULONG unique_idx,u64 locality_key);
   extern u8 spawn_multi(spawn_t *spawn_base,ULONG thread_idx_max);
+  extern u8 spawn_multi_bitmap(spawn_t *spawn_base,ULONG *bitmap_base,ULONG bit_idx_max);
+  extern u8 spawn_multi_deadline(spawn_t *spawn_base,ULONG thread_idx_max,u64 deadline_nanoseconds,u8 wrap_status,ULONG *done_bitmap_base);
+  extern u8 spawn_multi_list(spawn_t *spawn_base,ULONG *idx_list_base,ULONG idx_idx_max,u8 sort_status);
+  extern u8 spawn_multi_pipe_feed(spawn_pipe_t *pipe_base,u8 *item_base);
+  extern void spawn_multi_pipe_free(spawn_pipe_t *pipe_base);
+  extern spawn_pipe_t *spawn_multi_pipe_init(void (**function_list_base)(spawn_pipe_context_t *),u8 *readonly_string_base,u32 stage_idx_max,u32 *worker_idx_max_list_base,u8 queue_size_log2);
+  extern u8 spawn_multi_pipe_push(spawn_pipe_context_t *pipe_context_base,u8 *item_base);
+  extern void spawn_multi_pipe_retire_all(spawn_pipe_t *pipe_base);
   extern void spawn_multi_retire_all(spawn_t *spawn_base);
   extern void spawn_multi_free(spawn_t *spawn_base);
   extern void spawn_multi_rewind(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base,spawn_t *spawn_base);
+  extern spawn_share_t *spawn_multi_share_init(u32 slot_idx_max,u32 job_idx_max);
+  extern void spawn_multi_share_free(spawn_share_t *share_base);
+  extern u8 spawn_multi_share_join(spawn_share_t *share_base,spawn_t *spawn_base,u32 weight,u32 share_min,u32 share_max);
+  extern void spawn_multi_share_leave(spawn_t *spawn_base);
+  extern void spawn_multi_simulthread_limit_set(spawn_t *spawn_base,u32 simulthread_limit_idx_max);
+  extern u8 spawn_multi_stack_set(spawn_t *spawn_base,ULONG stack_size,ULONG guard_size,u8 pool_status);
   extern spawn_t *spawn_multi_init(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base,u32 simulthread_idx_max);
 #else
   extern u8 spawn_mono_one(spawn_t *spawn_base,ULONG unique_idx);
   extern u8 spawn_mono(spawn_t *spawn_base,ULONG thread_idx_max);
+  extern u8 spawn_mono_bitmap(spawn_t *spawn_base,ULONG *bitmap_base,ULONG bit_idx_max);
+  extern u8 spawn_mono_deadline(spawn_t *spawn_base,ULONG thread_idx_max,u64 deadline_nanoseconds,u8 wrap_status,ULONG *done_bitmap_base);
+  extern u8 spawn_mono_list(spawn_t *spawn_base,ULONG *idx_list_base,ULONG idx_idx_max,u8 sort_status);
+  extern u8 spawn_mono_pipe_feed(spawn_pipe_t *pipe_base,u8 *item_base);
+  extern void spawn_mono_pipe_free(spawn_pipe_t *pipe_base);
+  extern spawn_pipe_t *spawn_mono_pipe_init(void (**function_list_base)(spawn_pipe_context_t *),u8 *readonly_string_base,u32 stage_idx_max);
+  extern u8 spawn_mono_pipe_push(spawn_pipe_context_t *pipe_context_base,u8 *item_base);
+  extern u8 spawn_mono_profile_enable(spawn_t *spawn_base);
+  extern void spawn_mono_profile_free(spawn_t *spawn_base);
+  extern u8 spawn_mono_profile_predict(spawn_t *spawn_base,u32 simulthread_idx_max,u64 launch_nanoseconds,spawn_profile_prediction_t *prediction_base);
+  extern u8 spawn_mono_profile_print(spawn_t *spawn_base,FILE *file_base,u32 simulthread_idx_max,u64 launch_nanoseconds);
+  extern void spawn_mono_profile_reset(spawn_t *spawn_base);
   extern void spawn_mono_free(spawn_t *spawn_base);
   extern void spawn_mono_rewind(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base,spawn_t *spawn_base);
   extern spawn_t *spawn_mono_init(void (*function_base)(spawn_simulthread_context_t *),u8 *readonly_string_base);
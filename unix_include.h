@@ -20,10 +20,29 @@ You should have received a copy of the GNU Limited General Public
 License version 3 along with the Spawn Library (filename
 "COPYING"). If not, see http://www.gnu.org/licenses/ .
 */
+#ifndef _GNU_SOURCE
+  #define _GNU_SOURCE
+#endif
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 #ifdef PTHREAD
   #include <pthread.h>
+  #include <sched.h>
+#endif
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#ifdef __linux__
+  #include <linux/io_uring.h>
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
 #endif